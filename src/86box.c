@@ -109,6 +109,8 @@
 #include <86box/acpi.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 #include <86box/vfio.h>
+#include <86box/savestate.h>
+#include <86box/profiler.h>
 
 // Disable c99-designator to avoid the warnings about int ng
 #ifdef __clang__
@@ -156,6 +158,8 @@ uint8_t  instru_enabled                         = 0;
 uint64_t instru_run_ms                          = 0;
 #endif
 int      clear_flash                            = 0;
+int      batch_mode                             = 0;              /* (O) run as fast as possible */
+uint64_t batch_run_ms                           = 0;              /* (O) batch mode: emulated ms to run */
 int      auto_paused                            = 0;
 
 /* Configuration values. */
@@ -172,6 +176,7 @@ int      vid_cga_contrast                       = 0;              /* (C) video *
 int      video_fullscreen                       = 0;              /* (C) video */
 int      video_fullscreen_scale                 = 0;              /* (C) video */
 int      enable_overscan                        = 0;              /* (C) video */
+int      vid_render_thread                      = 0;              /* (C) render SVGA lines on a worker thread */
 int      force_43                               = 0;              /* (C) video */
 int      video_filter_method                    = 1;              /* (C) video */
 int      video_vsync                            = 0;              /* (C) video */
@@ -196,7 +201,10 @@ int      da2_standalone_enabled                 = 0;              /* (C) video o
 uint32_t mem_size                               = 0;              /* (C) memory size (Installed on
                                                                          system board)*/
 uint32_t isa_mem_size                           = 0;              /* (C) memory size (ISA Memory Cards) */
+char     mem_ram_image[1024]                    = { '\0' };   /* (C) golden RAM image, mapped copy-on-write */
 int      cpu_use_dynarec                        = 0;              /* (C) cpu uses/needs Dyna */
+int      dynarec_cache_size                     = 0;              /* (C) dynarec code cache in MB, 0 = default */
+int      dynarec_compile_budget                 = 0;              /* (C) dynarec uOPs compiled per slice, 0 = no limit */
 int      cpu                                    = 0;              /* (C) cpu type */
 int      fpu_type                               = 0;              /* (C) fpu type */
 int      fpu_softfloat                          = 0;              /* (C) fpu uses softfloat */
@@ -331,6 +339,9 @@ __thread int is_cpu_thread = 0;
 
 static wchar_t mouse_msg[3][200];
 
+static uint64_t batch_emu_ms     = 0;
+static uint32_t batch_host_start = 0;
+
 static volatile atomic_int do_pause_ack = 0;
 static volatile atomic_int pause_ack = 0;
 
@@ -657,6 +668,10 @@ pc_show_usage(char *s)
             "\n%sUsage: 86box [options] [cfg-file]\n\n"
             "Valid options are:\n\n"
             "-? or --help\t\t\t- show this information\n"
+            "-A or --profile path\t\t- profile the emulator from start-up and\n"
+            "\t\t\t\t   write the report to 'path' on exit\n"
+            "-B or --batch ms\t\t- run as fast as possible, without sound, and\n"
+            "\t\t\t\t   power off after 'ms' emulated ms (0 = never)\n"
 #ifdef SHOW_EXTRA_PARAMS
             "-C or --config path\t\t- set 'path' to be config file\n"
 #endif
@@ -678,11 +693,15 @@ pc_show_usage(char *s)
 #ifdef USE_INSTRUMENT
             "-J or --instrument name\t- set 'name' to be the profiling instrument\n"
 #endif
+            "-K or --loadstate path\t\t- resume from the save state in 'path'\n"
             "-L or --logfile path\t\t- set 'path' to be the logfile\n"
             "-M or --missing\t\t- dump missing machines and video cards\n"
             "-N or --noconfirm\t\t- do not ask for confirmation on quit\n"
             "-P or --vmpath path\t\t- set 'path' to be root for vm\n"
             "-O or --global path\t\t- set 'path' to be global config file\n"
+            "-Q or --savestate path\t\t- save the machine state to 'path' on exit\n"
+            "\t\t\t\t   (also writes the [Machine] ram_image, only on\n"
+            "\t\t\t\t   machines whose devices all support save states)\n"
             "-R or --rompath path\t\t- set 'path' to be ROM path\n"
 #ifndef USE_SDL_UI
             "-S or --settings\t\t\t- show only the settings dialog\n"
@@ -691,6 +710,8 @@ pc_show_usage(char *s)
             "-T or --testmode\t\t- test mode: execute the test mode entry\n"
             "\t\t\t\t   point on init/hard reset\n"
 #endif
+            "-U or --overlay what\t\t- commits or discards hard disk overlays\n"
+            "\t\t\t\t   (commit/discard) before starting\n"
             "-V or --vmname name\t\t- overrides the name of the running VM\n"
 #ifdef _WIN32
             "-W or --nohook\t\t- disables keyboard hook\n"
@@ -881,6 +902,39 @@ usage:
             pclog("Drive %c: %s\n", drive + 0x41, fn[(int) drive]);
             free(temp2);
             temp2 = NULL;
+        } else if (!strcasecmp(argv[c], "--batch") || !strcasecmp(argv[c], "-B")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            batch_mode   = 1;
+            batch_run_ms = strtoull(argv[++c], NULL, 10);
+        } else if (!strcasecmp(argv[c], "--profile") || !strcasecmp(argv[c], "-A")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snprintf(prof_report_path, sizeof(prof_report_path), "%s", argv[++c]);
+        } else if (!strcasecmp(argv[c], "--loadstate") || !strcasecmp(argv[c], "-K")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snprintf(savestate_load_path, sizeof(savestate_load_path), "%s", argv[++c]);
+        } else if (!strcasecmp(argv[c], "--savestate") || !strcasecmp(argv[c], "-Q")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snprintf(savestate_save_path, sizeof(savestate_save_path), "%s", argv[++c]);
+        } else if (!strcasecmp(argv[c], "--overlay") || !strcasecmp(argv[c], "-U")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            what = argv[++c];
+
+            if (!strcasecmp(what, "commit"))
+                hdd_overlay_action = HDD_OVERLAY_COMMIT;
+            else if (!strcasecmp(what, "discard"))
+                hdd_overlay_action = HDD_OVERLAY_DISCARD;
+            else
+                goto usage;
         } else if (!strcasecmp(argv[c], "--vmname") || !strcasecmp(argv[c], "-V")) {
             if ((c + 1) == argc)
                 goto usage;
@@ -1413,6 +1467,9 @@ pc_init_modules(void)
         exit(-1);
     }
 
+    if (prof_report_path[0] != '\0')
+        prof_start();
+
     return 1;
 }
 
@@ -1717,6 +1774,12 @@ pc_reset_hard_init(void)
     if (test_mode)
         pc_test_mode_entry_point();
 
+    /* Resume from the save state given on the command line, but only once. */
+    if (savestate_load_path[0] != '\0') {
+        savestate_load(savestate_load_path);
+        savestate_load_path[0] = '\0';
+    }
+
     ui_hard_reset_completed();
 }
 
@@ -1763,6 +1826,41 @@ pc_reset_hard(void)
     hard_reset_pending = 1;
 }
 
+static void
+pc_batch_report(void)
+{
+    uint32_t host_ms = plat_get_ticks() - batch_host_start;
+
+    always_log("[batch] %" PRIu64 " ms emulated in %u ms (%.2fx real time)\n",
+               batch_emu_ms, host_ms, host_ms ? ((double) batch_emu_ms / (double) host_ms) : 0.0);
+}
+
+/*
+ * Batch mode: called by the frontends after every pc_run(), which they
+ * then call again straight away instead of waiting for the host clock.
+ * Returns 1 once the requested time has run and the machine is being
+ * powered off.
+ */
+int
+pc_batch_frame(void)
+{
+    if (batch_emu_ms == 0)
+        batch_host_start = plat_get_ticks();
+
+    batch_emu_ms += force_10ms ? 10 : 1;
+
+    if ((batch_emu_ms % 10000ULL) == 0ULL)
+        pc_batch_report();
+
+    if (batch_run_ms && (batch_emu_ms >= batch_run_ms)) {
+        pc_batch_report();
+        plat_power_off();
+        return 1;
+    }
+
+    return 0;
+}
+
 void
 pc_close(UNUSED(thread_t *ptr))
 {
@@ -1779,6 +1877,22 @@ pc_close(UNUSED(thread_t *ptr))
 
     config_save();
 
+    if (savestate_save_path[0] != '\0')
+        savestate_save(savestate_save_path);
+
+    if (mem_ram_image[0] != '\0')
+        mem_ram_image_stats();
+
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    codegen_stats_log();
+#endif
+
+    prof_stop();
+
+    /* Otherwise it was already reported on power off. */
+    if (batch_mode && !batch_run_ms && batch_emu_ms)
+        pc_batch_report();
+
     plat_mouse_capture(0);
 
     /* Close all the memory mappings. */
@@ -1847,6 +1961,8 @@ pc_run(void)
     int     mouse_msg_idx;
     wchar_t temp[200];
 
+    prof_cat = PROF_OTHER;
+
     /* Trigger a hard reset if one is pending. */
     if (hard_reset_pending) {
         hard_reset_pending = 0;
@@ -1859,7 +1975,9 @@ pc_run(void)
 
     /* Run a block of code. */
     startblit();
+    prof_cat = PROF_INTERP;
     cpu_exec((int32_t) cpu_s->rspeed / (force_10ms ? 100 : 1000));
+    prof_cat = PROF_OTHER;
     ack_pause();
 #ifdef USE_GDBSTUB /* avoid a KBC FIFO overflow when CPU emulation is stalled */
     if (gdbstub_step == GDBSTUB_EXEC) {
@@ -1896,6 +2014,8 @@ pc_run(void)
 #endif
         title_update = 0;
     }
+
+    prof_cat = PROF_IDLE;
 }
 
 /* Handler for the 1-second timer to refresh the window title. */
@@ -13,6 +13,7 @@
  *          Copyright 2020 Miran Grca.
  */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -43,6 +44,7 @@
 #include <86box/hdc_ide.h>
 #include <86box/hdc_ide_sff8038i.h>
 #include <86box/sis_55xx.h>
+#include <86box/savestate.h>
 
 int        acpi_rtc_status     = 0;
 atomic_int acpi_pwrbut_pressed = 0;
@@ -2496,6 +2498,38 @@ acpi_close(void *priv)
     free(dev);
 }
 
+static void
+acpi_savestate(void *priv, savestate_t *st)
+{
+    acpi_t *dev = (acpi_t *) priv;
+
+    /* The VIA GPIO I2C bus keeps state of its own. */
+    if (st->saving && (dev->i2c != NULL))
+        savestate_refuse(st, "ACPI", "the GPIO I2C bus is in use");
+
+    /* The I/O bases are programmed, and restored, by the southbridge. */
+    savestate_rw(st, dev, offsetof(acpi_t, io_base));
+    savestate_rw(st, &dev->irq_mode, offsetof(acpi_t, timer) - offsetof(acpi_t, irq_mode));
+    savestate_timer(st, &dev->timer);
+    savestate_timer(st, &dev->resume_timer);
+    savestate_timer(st, &dev->pwrbtn_timer);
+    if ((dev->vendor & 0xffff) == 0x1039) {
+        savestate_timer(st, &dev->gp_timer);
+        savestate_timer(st, &dev->per_timer);
+    }
+    savestate_var(st, acpi_rtc_status);
+    savestate_var(st, acpi_power_on);
+    savestate_var(st, acpi_last_clock);
+    savestate_var(st, acpi_count);
+
+    if (st->saving || st->error)
+        return;
+
+    /* The device I/O traps follow the restored enable register. */
+    if (dev->trap_update)
+        dev->trap_update(dev->trap_priv);
+}
+
 static void *
 acpi_init(const device_t *info)
 {
@@ -2606,7 +2640,8 @@ const device_t acpi_ali_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
 
 const device_t acpi_intel_device = {
@@ -2620,7 +2655,8 @@ const device_t acpi_intel_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
 
 const device_t acpi_via_device = {
@@ -2634,7 +2670,8 @@ const device_t acpi_via_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
 
 const device_t acpi_via_596b_device = {
@@ -2648,7 +2685,8 @@ const device_t acpi_via_596b_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
 
 const device_t acpi_smc_device = {
@@ -2662,7 +2700,8 @@ const device_t acpi_smc_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
 
 const device_t acpi_sis_5582_device = {
@@ -2676,7 +2715,8 @@ const device_t acpi_sis_5582_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
 
 const device_t acpi_sis_5595_1997_device = {
@@ -2690,7 +2730,8 @@ const device_t acpi_sis_5595_1997_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
 
 const device_t acpi_sis_5595_device = {
@@ -2704,5 +2745,6 @@ const device_t acpi_sis_5595_device = {
     .available     = NULL,
     .speed_changed = acpi_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = acpi_savestate
 };
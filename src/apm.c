@@ -23,7 +23,9 @@
 #include "cpu.h"
 #include <86box/device.h>
 #include <86box/io.h>
+#include <86box/timer.h>
 #include <86box/apm.h>
+#include <86box/savestate.h>
 
 #ifdef ENABLE_APM_LOG
 int apm_do_log = ENABLE_APM_LOG;
@@ -92,6 +94,16 @@ apm_reset(void *priv)
     dev->cmd = dev->stat = 0x00;
 }
 
+static void
+apm_savestate(void *priv, savestate_t *st)
+{
+    apm_t *dev = (apm_t *) priv;
+
+    savestate_var(st, dev->cmd);
+    savestate_var(st, dev->stat);
+    savestate_var(st, dev->do_smi);
+}
+
 static void
 apm_close(void *priv)
 {
@@ -123,7 +135,8 @@ const device_t apm_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = apm_savestate
 };
 
 const device_t apm_pci_device = {
@@ -137,7 +150,8 @@ const device_t apm_pci_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = apm_savestate
 };
 
 const device_t apm_pci_acpi_device = {
@@ -151,5 +165,6 @@ const device_t apm_pci_acpi_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = apm_savestate
 };
@@ -31,6 +31,8 @@
 #include <86box/spd.h>
 #include <86box/machine.h>
 #include <86box/agpgart.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 
 enum {
     INTEL_420TX,
@@ -1597,6 +1599,44 @@ i4x0_reset(void *priv)
     }
 }
 
+static void
+i4x0_savestate(void *priv, savestate_t *st)
+{
+    i4x0_t *dev = (i4x0_t *) priv;
+
+    /* Tear down the SMRAM mappings of the current configuration first. */
+    if (!st->saving)
+        i4x0_smram_handler_phase0(dev);
+
+    /* The PAM state cache keeps describing the current mappings. */
+    savestate_var(st, dev->pm2_cntrl);
+    savestate_var(st, dev->smram_locked);
+    savestate_var(st, dev->regs);
+    savestate_var(st, dev->regs_locked);
+
+    if (st->saving || st->error)
+        return;
+
+    if (dev->type <= INTEL_430NX)
+        i4x0_map(dev, 0x80000, 0x20000, dev->regs[0x59] & 0x0f);
+    i4x0_map(dev, 0xf0000, 0x10000, dev->regs[0x59] >> 4);
+    for (uint8_t i = 0; i < 6; i++) {
+        i4x0_map(dev, 0xc0000 + (i << 15), 0x04000, dev->regs[0x5a + i] & 0x0f);
+        i4x0_map(dev, 0xc4000 + (i << 15), 0x04000, dev->regs[0x5a + i] >> 4);
+    }
+
+    i4x0_smram_handler_phase1(dev);
+
+    if (dev->type == INTEL_430TX) {
+        io_removehandler(0x0022, 0x01, pm2_cntrl_read, NULL, NULL, pm2_cntrl_write, NULL, NULL, dev);
+        if (dev->regs[0x79] & 0x40)
+            io_sethandler(0x0022, 0x01, pm2_cntrl_read, NULL, NULL, pm2_cntrl_write, NULL, NULL, dev);
+    }
+
+    if (dev->agpgart != NULL)
+        i4x0_mask_bar(dev->regs, dev->agpgart);
+}
+
 static void
 i4x0_close(void *priv)
 {
@@ -1976,7 +2016,8 @@ const device_t i420tx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i420zx_device = {
@@ -1990,7 +2031,8 @@ const device_t i420zx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i430lx_device = {
@@ -2004,7 +2046,8 @@ const device_t i430lx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i430nx_device = {
@@ -2018,7 +2061,8 @@ const device_t i430nx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i430fx_device = {
@@ -2032,7 +2076,8 @@ const device_t i430fx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i430fx_rev02_device = {
@@ -2046,7 +2091,8 @@ const device_t i430fx_rev02_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i430hx_device = {
@@ -2060,7 +2106,8 @@ const device_t i430hx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i430vx_device = {
@@ -2074,7 +2121,8 @@ const device_t i430vx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i430tx_device = {
@@ -2088,7 +2136,8 @@ const device_t i430tx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i440fx_device = {
@@ -2102,7 +2151,8 @@ const device_t i440fx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i440lx_device = {
@@ -2116,7 +2166,8 @@ const device_t i440lx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i440ex_device = {
@@ -2130,7 +2181,8 @@ const device_t i440ex_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i440bx_device = {
@@ -2144,7 +2196,8 @@ const device_t i440bx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i440bx_no_agp_device = {
@@ -2158,7 +2211,8 @@ const device_t i440bx_no_agp_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i440gx_device = {
@@ -2172,7 +2226,8 @@ const device_t i440gx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
 
 const device_t i440zx_device = {
@@ -2186,5 +2241,6 @@ const device_t i440zx_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = i4x0_savestate
 };
@@ -32,6 +32,7 @@
 #include <86box/machine.h>
 #include <86box/mem.h>
 #include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/nvr.h>
 #include <86box/acpi.h>
 #include <86box/ddma.h>
@@ -1519,6 +1520,55 @@ piix_reset(void *priv)
         sff_set_irq_mode(dev->bm[1], IRQ_MODE_MIRQ_0);
 }
 
+static void
+piix4_savestate(void *priv, savestate_t *st)
+{
+    piix_t  *dev = (piix_t *) priv;
+    uint16_t base;
+
+    /* The I/O bases describe the current mappings and are recomputed below. */
+    savestate_var(st, dev->regs);
+    savestate_var(st, dev->max_func);
+
+    if (st->saving || st->error)
+        return;
+
+    dma_alias_remove();
+    if (!(dev->regs[0][0x4c] & 0x80))
+        dma_alias_set();
+    kbc_alias_update_io_mapping(dev);
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (dev->regs[0][0x60 + i] & 0x80)
+            pci_set_irq_routing(PCI_INTA + i, PCI_IRQ_DISABLED);
+        else
+            pci_set_irq_routing(PCI_INTA + i, dev->regs[0][0x60 + i] & 0xf);
+    }
+
+    for (uint8_t addr = 0x92; addr <= 0x94; addr += 2) {
+        base = (dev->regs[0][addr + 1] << 8) | dev->regs[0][addr];
+        for (uint8_t i = 0; i < 4; i++)
+            ddma_update_io_mapping(dev->ddma, (addr & 4) + i, dev->regs[0][addr] + (i << 4), dev->regs[0][addr + 1], (base != 0x0000));
+    }
+
+    alt_access = !!(dev->regs[0][0xb0] & 0x20);
+
+    nvr_update_io_mapping(dev);
+    nvr_wp_set(!!(dev->regs[0][0xcb] & 0x08), 0, dev->nvr);
+    nvr_wp_set(!!(dev->regs[0][0xcb] & 0x10), 1, dev->nvr);
+    nvr_read_addr_set(!!(dev->regs[2][0xff] & 0x10), dev->nvr);
+
+    piix_ide_handlers(dev, 0x03);
+    piix_ide_bm_handlers(dev);
+
+    uhci_update_io_mapping(dev->usb, dev->regs[2][0x20] & ~0x1f, dev->regs[2][0x21], dev->regs[2][PCI_REG_COMMAND] & PCI_COMMAND_IO);
+
+    smbus_update_io_mapping(dev);
+    dev->acpi_io_base = (dev->regs[3][0x41] << 8) | (dev->regs[3][0x40] & 0xc0);
+    acpi_update_io_mapping(dev->acpi, dev->acpi_io_base, (dev->regs[3][0x80] & 0x01));
+    /* The I/O traps are re-armed by the ACPI device once its registers are back. */
+}
+
 static void
 piix_close(void *priv)
 {
@@ -1724,7 +1774,8 @@ const device_t piix4_device = {
     .available     = NULL,
     .speed_changed = piix_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = piix4_savestate
 };
 
 const device_t piix4e_device = {
@@ -1738,7 +1789,8 @@ const device_t piix4e_device = {
     .available     = NULL,
     .speed_changed = piix_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = piix4_savestate
 };
 
 const device_t slc90e66_device = {
@@ -588,6 +588,7 @@ wd76c10_recalc_exec(wd76c10_t *dev, uint32_t base, uint32_t size)
         if (dev->ram_state[i >> 12])
             _mem_exec[i >> 12] = exec;
 
+    mem_exec_gen++;
     if (cpu_use_exec)
         flushmmucache_nopc();
 }
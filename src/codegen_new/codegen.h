@@ -38,11 +38,19 @@ typedef struct codeblock_t {
     uint16_t flags;
     uint8_t  ins;
     uint8_t  TOP;
+    /*Executions since the block was last passed over by the eviction clock,
+      saturating. Halved on each pass, the block is evicted when it reaches 0.*/
+    uint8_t  hotness;
 
     /*Pointers for codeblock tree, used to search for blocks when hash lookup
       fails.*/
     uint16_t parent, left, right;
 
+    /*Block that last ran straight after this one, in the same page. The
+      dispatcher jumps to it directly if it is still valid for the current
+      state, without going back through the main loop and the hash lookup.*/
+    uint16_t chain_next;
+
     uint8_t *data;
 
     uint64_t  page_mask, page_mask2;
@@ -309,9 +317,47 @@ extern void codegen_check_seg_write(codeblock_t *block, struct ir_data_t *ir, x8
 extern void codegen_check_regs(void);
 
 extern int codegen_purge_purgable_list(void);
-/*Delete a random code block to free memory. This is obviously quite expensive, and
-  will only be called when the allocator is out of memory*/
-extern void codegen_delete_random_block(int required_mem_block);
+/*Delete the least recently executed code block to free memory, using a clock
+  over the block array. This is obviously quite expensive, and will only be called
+  when the allocator or the block array is out of space*/
+extern void codegen_delete_cold_block(int required_mem_block);
+
+typedef struct codegen_stats_t {
+    uint64_t hits;       /*Compiled blocks executed*/
+    uint64_t marks;      /*New blocks interpreted and marked for compilation*/
+    uint64_t recompiles; /*Blocks compiled*/
+    uint64_t evictions;  /*Live blocks deleted to make space*/
+    uint64_t dispatches; /*Dispatcher entries from the main loop*/
+    uint64_t chained;    /*Blocks entered directly from the previous one*/
+    uint64_t ir_uops;    /*uOPs generated*/
+    uint64_t ir_folded;  /*uOPs rewritten by constant propagation*/
+    uint64_t ir_dead;    /*uOPs removed as their results are never read*/
+    uint64_t deferred;   /*Marked blocks interpreted as the compile budget was used up*/
+    uint64_t compile_us; /*Host time spent compiling blocks, in microseconds*/
+
+    /*Worst compile work done in a single pc_run() slice*/
+    uint64_t slice_max_uops;
+    uint64_t slice_max_blocks;
+    uint64_t slice_max_us;
+} codegen_stats_t;
+
+extern codegen_stats_t codegen_stats;
+
+/*Compile work done in the current slice, see dynarec_compile_budget*/
+extern uint64_t codegen_slice_uops;
+extern uint64_t codegen_slice_blocks;
+extern uint64_t codegen_slice_us;
+
+extern void codegen_slice_start(void);
+
+/*Returns 1 if marked blocks should stay interpreted for the rest of this
+  slice, so that a burst of compilation does not stall the emulation thread
+  for longer than the budget allows.*/
+static inline int
+codegen_compile_deferred(void)
+{
+    return dynarec_compile_budget && (codegen_slice_uops >= (uint64_t) dynarec_compile_budget);
+}
 
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
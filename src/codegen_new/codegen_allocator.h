@@ -12,12 +12,19 @@
 
   Due to the chaining, the total memory size is limited by the range of a jump
   instruction. ARMv8 is limited to +/- 128 MB, x86 to
-  +/- 2GB. It was 32 MB on ARMv7 before we removed it*/
+  +/- 2GB. It was 32 MB on ARMv7 before we removed it.
 
-#define MEM_BLOCK_NR 131072
+  The number of blocks can be changed with the dynarec_cache_size option, within
+  MEM_BLOCK_NR_MIN and MEM_BLOCK_NR_MAX.*/
 
+#define MEM_BLOCK_NR     131072
+#define MEM_BLOCK_NR_MIN 4096
+#if defined __aarch64__ || defined _M_ARM64
+#    define MEM_BLOCK_NR_MAX 131072
+#else
+#    define MEM_BLOCK_NR_MAX 1048576
+#endif
 
-#define MEM_BLOCK_MASK (MEM_BLOCK_NR - 1)
 #define MEM_BLOCK_SIZE 0x3c0
 
 void codegen_allocator_init(void);
@@ -32,6 +39,7 @@ uint8_t *codeblock_allocator_get_ptr(struct mem_block_t *block);
 /*Cache clean memory block list*/
 void codegen_allocator_clean_blocks(struct mem_block_t *block);
 
-extern int codegen_allocator_usage;
+extern int      codegen_allocator_usage;
+extern uint32_t codegen_allocator_blocks;
 
 #endif
@@ -43,6 +43,10 @@ int        block_current = 0;
 static int block_num;
 int        block_pos;
 
+uint64_t codegen_slice_uops;
+uint64_t codegen_slice_blocks;
+uint64_t codegen_slice_us;
+
 uint32_t codegen_endpc;
 
 int        codegen_block_cycles;
@@ -57,7 +61,10 @@ static int      last_ssegs;
 uint32_t instr_counts[256 * 256];
 #endif
 
+codegen_stats_t codegen_stats;
+
 static uint16_t block_free_list;
+static int      block_clock_hand;
 static void     delete_block(codeblock_t *block);
 static void     delete_dirty_block(codeblock_t *block);
 
@@ -204,7 +211,7 @@ block_free_list_get(void)
         }
         /*Free list is empty - free up a block*/
         if (!codegen_purge_purgable_list())
-            codegen_delete_random_block(0);
+            codegen_delete_cold_block(0);
     }
 
     block           = &codeblock[block_free_list];
@@ -396,7 +403,8 @@ delete_block(codeblock_t *block)
     if (block->pc == BLOCK_PC_INVALID)
         fatal("Deleting deleted block\n");
 #endif
-    block->pc = BLOCK_PC_INVALID;
+    block->pc         = BLOCK_PC_INVALID;
+    block->chain_next = BLOCK_INVALID;
 
     codeblock_tree_delete(block);
     if (block->flags & CODEBLOCK_IN_DIRTY_LIST)
@@ -419,7 +427,8 @@ delete_dirty_block(codeblock_t *block)
     if (block->pc == BLOCK_PC_INVALID)
         fatal("Deleting deleted block\n");
 #endif
-    block->pc = BLOCK_PC_INVALID;
+    block->pc         = BLOCK_PC_INVALID;
+    block->chain_next = BLOCK_INVALID;
 
     codeblock_tree_delete(block);
     block_free_list_add(block);
@@ -433,23 +442,72 @@ codegen_delete_block(codeblock_t *block)
 }
 
 void
-codegen_delete_random_block(int required_mem_block)
+codegen_delete_cold_block(int required_mem_block)
 {
-    int block_nr = rand() & BLOCK_MASK;
+    int block_nr = block_clock_hand;
 
     while (1) {
         if (block_nr && block_nr != block_current) {
             codeblock_t *block = &codeblock[block_nr];
 
             if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block)) {
-                delete_block(block);
-                return;
+                /*Second chance, scaled by how often the block ran since the last pass*/
+                if (block->hotness)
+                    block->hotness >>= 1;
+                else {
+                    delete_block(block);
+                    codegen_stats.evictions++;
+                    block_clock_hand = (block_nr + 1) & BLOCK_MASK;
+                    return;
+                }
             }
         }
         block_nr = (block_nr + 1) & BLOCK_MASK;
     }
 }
 
+/*Called at the start of every pc_run() slice.*/
+void
+codegen_slice_start(void)
+{
+    if (codegen_slice_uops > codegen_stats.slice_max_uops) {
+        codegen_stats.slice_max_uops   = codegen_slice_uops;
+        codegen_stats.slice_max_blocks = codegen_slice_blocks;
+    }
+    if (codegen_slice_us > codegen_stats.slice_max_us)
+        codegen_stats.slice_max_us = codegen_slice_us;
+    codegen_stats.compile_us += codegen_slice_us;
+
+    codegen_slice_uops   = 0;
+    codegen_slice_blocks = 0;
+    codegen_slice_us     = 0;
+}
+
+void
+codegen_stats_log(void)
+{
+    uint64_t total = codegen_stats.hits + codegen_stats.marks + codegen_stats.recompiles;
+
+    if (!total)
+        return;
+
+    pclog("CODEGEN: %" PRIu64 " block hits (%i.%i%%), %" PRIu64 " marked, %" PRIu64 " compiled, "
+          "%" PRIu64 " evicted, %i/%u memory blocks in use\n",
+          codegen_stats.hits, (int) ((codegen_stats.hits * 1000) / total) / 10,
+          (int) ((codegen_stats.hits * 1000) / total) % 10,
+          codegen_stats.marks, codegen_stats.recompiles, codegen_stats.evictions,
+          codegen_allocator_usage, codegen_allocator_blocks);
+    pclog("CODEGEN: %" PRIu64 " dispatches (%.0f per emulated second), %" PRIu64 " chained blocks\n",
+          codegen_stats.dispatches, (tsc > 0) ? ((double) codegen_stats.dispatches * cpu_s->rspeed / (double) tsc) : 0.0,
+          codegen_stats.chained);
+    pclog("CODEGEN: %" PRIu64 " uOPs generated, %" PRIu64 " folded by constant propagation, %" PRIu64 " removed as dead\n",
+          codegen_stats.ir_uops, codegen_stats.ir_folded, codegen_stats.ir_dead);
+    pclog("CODEGEN: Worst slice compiled %" PRIu64 " uOPs in %" PRIu64 " blocks, %" PRIu64 " blocks deferred\n",
+          codegen_stats.slice_max_uops, codegen_stats.slice_max_blocks, codegen_stats.deferred);
+    pclog("CODEGEN: %" PRIu64 " us spent compiling, at most %" PRIu64 " us in a single slice\n",
+          codegen_stats.compile_us, codegen_stats.slice_max_us);
+}
+
 void
 codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_addr))
 {
@@ -530,9 +588,12 @@ codegen_block_init(uint32_t phys_addr)
     block->page_mask = block->page_mask2 = 0;
     block->flags                         = CODEBLOCK_STATIC_TOP;
     block->status                        = cpu_cur_status;
+    block->hotness                       = 0;
+    block->chain_next                    = BLOCK_INVALID;
 
     recomp_page = block->phys & ~0xfff;
     codeblock_tree_add(block);
+    codegen_stats.marks++;
 }
 
 static ir_data_t *ir_data;
@@ -580,6 +641,8 @@ codegen_block_start_recompile(codeblock_t *block)
     codegen_block_full_ins = 0;
 
     recomp_page = block->phys & ~0xfff;
+    codegen_stats.recompiles++;
+    codegen_slice_blocks++;
 
     codegen_flags_changed = 0;
     codegen_fpu_entered   = 0;
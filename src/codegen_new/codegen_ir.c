@@ -1,4 +1,8 @@
+#include <stdarg.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#define HAVE_STDARG_H
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
@@ -13,6 +17,212 @@
 extern int       has_ea;
 static ir_data_t ir_block;
 
+#ifdef ENABLE_CODEGEN_IR_LOG
+int codegen_ir_do_log = ENABLE_CODEGEN_IR_LOG;
+
+static void
+codegen_ir_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (codegen_ir_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+
+static const char *uop_names[UOP_MAX + 1] = {
+    [UOP_LOAD_FUNC_ARG_0 & UOP_MASK]        = "LOAD_FUNC_ARG_0",
+    [UOP_LOAD_FUNC_ARG_1 & UOP_MASK]        = "LOAD_FUNC_ARG_1",
+    [UOP_LOAD_FUNC_ARG_2 & UOP_MASK]        = "LOAD_FUNC_ARG_2",
+    [UOP_LOAD_FUNC_ARG_3 & UOP_MASK]        = "LOAD_FUNC_ARG_3",
+    [UOP_LOAD_FUNC_ARG_0_IMM & UOP_MASK]    = "LOAD_FUNC_ARG_0_IMM",
+    [UOP_LOAD_FUNC_ARG_1_IMM & UOP_MASK]    = "LOAD_FUNC_ARG_1_IMM",
+    [UOP_LOAD_FUNC_ARG_2_IMM & UOP_MASK]    = "LOAD_FUNC_ARG_2_IMM",
+    [UOP_LOAD_FUNC_ARG_3_IMM & UOP_MASK]    = "LOAD_FUNC_ARG_3_IMM",
+    [UOP_CALL_FUNC & UOP_MASK]              = "CALL_FUNC",
+    [UOP_CALL_INSTRUCTION_FUNC & UOP_MASK]  = "CALL_INSTRUCTION_FUNC",
+    [UOP_STORE_P_IMM & UOP_MASK]            = "STORE_P_IMM",
+    [UOP_STORE_P_IMM_8 & UOP_MASK]          = "STORE_P_IMM_8",
+    [UOP_LOAD_SEG & UOP_MASK]               = "LOAD_SEG",
+    [UOP_JMP & UOP_MASK]                    = "JMP",
+    [UOP_CALL_FUNC_RESULT & UOP_MASK]       = "CALL_FUNC_RESULT",
+    [UOP_JMP_DEST & UOP_MASK]               = "JMP_DEST",
+    [UOP_NOP_BARRIER & UOP_MASK]            = "NOP_BARRIER",
+    [UOP_STORE_P_IMM_16 & UOP_MASK]         = "STORE_P_IMM_16",
+    [UOP_MOV_PTR & UOP_MASK]                = "MOV_PTR",
+    [UOP_MOV_IMM & UOP_MASK]                = "MOV_IMM",
+    [UOP_MOV & UOP_MASK]                    = "MOV",
+    [UOP_MOVZX & UOP_MASK]                  = "MOVZX",
+    [UOP_MOVSX & UOP_MASK]                  = "MOVSX",
+    [UOP_MOV_DOUBLE_INT & UOP_MASK]         = "MOV_DOUBLE_INT",
+    [UOP_MOV_INT_DOUBLE & UOP_MASK]         = "MOV_INT_DOUBLE",
+    [UOP_MOV_INT_DOUBLE_64 & UOP_MASK]      = "MOV_INT_DOUBLE_64",
+    [UOP_MOV_REG_PTR & UOP_MASK]            = "MOV_REG_PTR",
+    [UOP_MOVZX_REG_PTR_8 & UOP_MASK]        = "MOVZX_REG_PTR_8",
+    [UOP_MOVZX_REG_PTR_16 & UOP_MASK]       = "MOVZX_REG_PTR_16",
+    [UOP_ADD & UOP_MASK]                    = "ADD",
+    [UOP_ADD_IMM & UOP_MASK]                = "ADD_IMM",
+    [UOP_AND & UOP_MASK]                    = "AND",
+    [UOP_AND_IMM & UOP_MASK]                = "AND_IMM",
+    [UOP_ADD_LSHIFT & UOP_MASK]             = "ADD_LSHIFT",
+    [UOP_OR & UOP_MASK]                     = "OR",
+    [UOP_OR_IMM & UOP_MASK]                 = "OR_IMM",
+    [UOP_SUB & UOP_MASK]                    = "SUB",
+    [UOP_SUB_IMM & UOP_MASK]                = "SUB_IMM",
+    [UOP_XOR & UOP_MASK]                    = "XOR",
+    [UOP_XOR_IMM & UOP_MASK]                = "XOR_IMM",
+    [UOP_ANDN & UOP_MASK]                   = "ANDN",
+    [UOP_MEM_LOAD_ABS & UOP_MASK]           = "MEM_LOAD_ABS",
+    [UOP_MEM_LOAD_REG & UOP_MASK]           = "MEM_LOAD_REG",
+    [UOP_MEM_STORE_ABS & UOP_MASK]          = "MEM_STORE_ABS",
+    [UOP_MEM_STORE_REG & UOP_MASK]          = "MEM_STORE_REG",
+    [UOP_MEM_STORE_IMM_8 & UOP_MASK]        = "MEM_STORE_IMM_8",
+    [UOP_MEM_STORE_IMM_16 & UOP_MASK]       = "MEM_STORE_IMM_16",
+    [UOP_MEM_STORE_IMM_32 & UOP_MASK]       = "MEM_STORE_IMM_32",
+    [UOP_MEM_LOAD_SINGLE & UOP_MASK]        = "MEM_LOAD_SINGLE",
+    [UOP_CMP_IMM_JZ & UOP_MASK]             = "CMP_IMM_JZ",
+    [UOP_MEM_LOAD_DOUBLE & UOP_MASK]        = "MEM_LOAD_DOUBLE",
+    [UOP_MEM_STORE_SINGLE & UOP_MASK]       = "MEM_STORE_SINGLE",
+    [UOP_MEM_STORE_DOUBLE & UOP_MASK]       = "MEM_STORE_DOUBLE",
+    [UOP_CMP_JB & UOP_MASK]                 = "CMP_JB",
+    [UOP_CMP_JNBE & UOP_MASK]               = "CMP_JNBE",
+    [UOP_SAR & UOP_MASK]                    = "SAR",
+    [UOP_SAR_IMM & UOP_MASK]                = "SAR_IMM",
+    [UOP_SHL & UOP_MASK]                    = "SHL",
+    [UOP_SHL_IMM & UOP_MASK]                = "SHL_IMM",
+    [UOP_SHR & UOP_MASK]                    = "SHR",
+    [UOP_SHR_IMM & UOP_MASK]                = "SHR_IMM",
+    [UOP_ROL & UOP_MASK]                    = "ROL",
+    [UOP_ROL_IMM & UOP_MASK]                = "ROL_IMM",
+    [UOP_ROR & UOP_MASK]                    = "ROR",
+    [UOP_ROR_IMM & UOP_MASK]                = "ROR_IMM",
+    [UOP_CMP_IMM_JZ_DEST & UOP_MASK]        = "CMP_IMM_JZ_DEST",
+    [UOP_CMP_IMM_JNZ_DEST & UOP_MASK]       = "CMP_IMM_JNZ_DEST",
+    [UOP_CMP_JB_DEST & UOP_MASK]            = "CMP_JB_DEST",
+    [UOP_CMP_JNB_DEST & UOP_MASK]           = "CMP_JNB_DEST",
+    [UOP_CMP_JO_DEST & UOP_MASK]            = "CMP_JO_DEST",
+    [UOP_CMP_JNO_DEST & UOP_MASK]           = "CMP_JNO_DEST",
+    [UOP_CMP_JZ_DEST & UOP_MASK]            = "CMP_JZ_DEST",
+    [UOP_CMP_JNZ_DEST & UOP_MASK]           = "CMP_JNZ_DEST",
+    [UOP_CMP_JL_DEST & UOP_MASK]            = "CMP_JL_DEST",
+    [UOP_CMP_JNL_DEST & UOP_MASK]           = "CMP_JNL_DEST",
+    [UOP_CMP_JBE_DEST & UOP_MASK]           = "CMP_JBE_DEST",
+    [UOP_CMP_JNBE_DEST & UOP_MASK]          = "CMP_JNBE_DEST",
+    [UOP_CMP_JLE_DEST & UOP_MASK]           = "CMP_JLE_DEST",
+    [UOP_CMP_JNLE_DEST & UOP_MASK]          = "CMP_JNLE_DEST",
+    [UOP_TEST_JNS_DEST & UOP_MASK]          = "TEST_JNS_DEST",
+    [UOP_TEST_JS_DEST & UOP_MASK]           = "TEST_JS_DEST",
+    [UOP_FP_ENTER & UOP_MASK]               = "FP_ENTER",
+    [UOP_FADD & UOP_MASK]                   = "FADD",
+    [UOP_FSUB & UOP_MASK]                   = "FSUB",
+    [UOP_FMUL & UOP_MASK]                   = "FMUL",
+    [UOP_FDIV & UOP_MASK]                   = "FDIV",
+    [UOP_FCOM & UOP_MASK]                   = "FCOM",
+    [UOP_FABS & UOP_MASK]                   = "FABS",
+    [UOP_FCHS & UOP_MASK]                   = "FCHS",
+    [UOP_FTST & UOP_MASK]                   = "FTST",
+    [UOP_FSQRT & UOP_MASK]                  = "FSQRT",
+    [UOP_MMX_ENTER & UOP_MASK]              = "MMX_ENTER",
+    [UOP_PADDB & UOP_MASK]                  = "PADDB",
+    [UOP_PADDW & UOP_MASK]                  = "PADDW",
+    [UOP_PADDD & UOP_MASK]                  = "PADDD",
+    [UOP_PADDSB & UOP_MASK]                 = "PADDSB",
+    [UOP_PADDSW & UOP_MASK]                 = "PADDSW",
+    [UOP_PADDUSB & UOP_MASK]                = "PADDUSB",
+    [UOP_PADDUSW & UOP_MASK]                = "PADDUSW",
+    [UOP_PSUBB & UOP_MASK]                  = "PSUBB",
+    [UOP_PSUBW & UOP_MASK]                  = "PSUBW",
+    [UOP_PSUBD & UOP_MASK]                  = "PSUBD",
+    [UOP_PSUBSB & UOP_MASK]                 = "PSUBSB",
+    [UOP_PSUBSW & UOP_MASK]                 = "PSUBSW",
+    [UOP_PSUBUSB & UOP_MASK]                = "PSUBUSB",
+    [UOP_PSUBUSW & UOP_MASK]                = "PSUBUSW",
+    [UOP_PSLLW_IMM & UOP_MASK]              = "PSLLW_IMM",
+    [UOP_PSLLD_IMM & UOP_MASK]              = "PSLLD_IMM",
+    [UOP_PSLLQ_IMM & UOP_MASK]              = "PSLLQ_IMM",
+    [UOP_PSRAW_IMM & UOP_MASK]              = "PSRAW_IMM",
+    [UOP_PSRAD_IMM & UOP_MASK]              = "PSRAD_IMM",
+    [UOP_PSRAQ_IMM & UOP_MASK]              = "PSRAQ_IMM",
+    [UOP_PSRLW_IMM & UOP_MASK]              = "PSRLW_IMM",
+    [UOP_PSRLD_IMM & UOP_MASK]              = "PSRLD_IMM",
+    [UOP_PSRLQ_IMM & UOP_MASK]              = "PSRLQ_IMM",
+    [UOP_PCMPEQB & UOP_MASK]                = "PCMPEQB",
+    [UOP_PCMPEQW & UOP_MASK]                = "PCMPEQW",
+    [UOP_PCMPEQD & UOP_MASK]                = "PCMPEQD",
+    [UOP_PCMPGTB & UOP_MASK]                = "PCMPGTB",
+    [UOP_PCMPGTW & UOP_MASK]                = "PCMPGTW",
+    [UOP_PCMPGTD & UOP_MASK]                = "PCMPGTD",
+    [UOP_PUNPCKLBW & UOP_MASK]              = "PUNPCKLBW",
+    [UOP_PUNPCKLWD & UOP_MASK]              = "PUNPCKLWD",
+    [UOP_PUNPCKLDQ & UOP_MASK]              = "PUNPCKLDQ",
+    [UOP_PUNPCKHBW & UOP_MASK]              = "PUNPCKHBW",
+    [UOP_PUNPCKHWD & UOP_MASK]              = "PUNPCKHWD",
+    [UOP_PUNPCKHDQ & UOP_MASK]              = "PUNPCKHDQ",
+    [UOP_PACKSSWB & UOP_MASK]               = "PACKSSWB",
+    [UOP_PACKSSDW & UOP_MASK]               = "PACKSSDW",
+    [UOP_PACKUSWB & UOP_MASK]               = "PACKUSWB",
+    [UOP_PMULLW & UOP_MASK]                 = "PMULLW",
+    [UOP_PMULHW & UOP_MASK]                 = "PMULHW",
+    [UOP_PMADDWD & UOP_MASK]                = "PMADDWD",
+    [UOP_PFADD & UOP_MASK]                  = "PFADD",
+    [UOP_PFSUB & UOP_MASK]                  = "PFSUB",
+    [UOP_PFMUL & UOP_MASK]                  = "PFMUL",
+    [UOP_PFMAX & UOP_MASK]                  = "PFMAX",
+    [UOP_PFMIN & UOP_MASK]                  = "PFMIN",
+    [UOP_PFCMPEQ & UOP_MASK]                = "PFCMPEQ",
+    [UOP_PFCMPGE & UOP_MASK]                = "PFCMPGE",
+    [UOP_PFCMPGT & UOP_MASK]                = "PFCMPGT",
+    [UOP_PF2ID & UOP_MASK]                  = "PF2ID",
+    [UOP_PI2FD & UOP_MASK]                  = "PI2FD",
+    [UOP_PFRCP & UOP_MASK]                  = "PFRCP",
+    [UOP_PFRSQRT & UOP_MASK]                = "PFRSQRT",
+};
+
+static void
+codegen_ir_dump_reg(const char *name, ir_reg_t ir_reg)
+{
+    static const char sizes[8] = { 'l', 'w', 'b', 'h', 'd', 'q', '?', '?' };
+
+    if (!ir_reg_is_invalid(ir_reg))
+        codegen_ir_log(" %s=r%i%c.%i", name, IREG_GET_REG(ir_reg.reg),
+                       sizes[IREG_GET_SIZE(ir_reg.reg) >> IREG_SIZE_SHIFT], ir_reg.version);
+}
+
+/*Dump the uOP list of a block, with register versions, to the log.*/
+static void
+codegen_ir_dump(ir_data_t *ir, codeblock_t *block, const char *stage)
+{
+    codegen_ir_log("IR %s: block %08x (phys %08x), %i uOPs\n", stage, block->pc, block->phys, ir->wr_pos);
+
+    for (int c = 0; c < ir->wr_pos; c++) {
+        const uop_t *uop  = &ir->uops[c];
+        int          type = uop->type & UOP_MASK;
+
+        if (type == UOP_INVALID) {
+            codegen_ir_log("  %4i  -\n", c);
+            continue;
+        }
+
+        codegen_ir_log("  %4i  %08x %-16s", c, uop->pc, ((type <= UOP_MAX) && uop_names[type]) ? uop_names[type] : "?");
+        codegen_ir_dump_reg("d", uop->dest_reg_a);
+        codegen_ir_dump_reg("a", uop->src_reg_a);
+        codegen_ir_dump_reg("b", uop->src_reg_b);
+        codegen_ir_dump_reg("c", uop->src_reg_c);
+        if (uop->type & UOP_TYPE_PARAMS_IMM)
+            codegen_ir_log(" imm=%08x", (uint32_t) uop->imm_data);
+        if (uop->type & UOP_TYPE_JUMP)
+            codegen_ir_log(" ->%i", uop->jump_dest_uop);
+        codegen_ir_log("%s%s\n", (uop->type & UOP_TYPE_BARRIER) ? " [barrier]" : "",
+                       (uop->type & UOP_TYPE_ORDER_BARRIER) ? " [order]" : "");
+    }
+}
+#else
+#    define codegen_ir_log(fmt, ...)
+#    define codegen_ir_dump(ir, block, stage)
+#endif
+
 static int codegen_unroll_start;
 static int codegen_unroll_count;
 static int codegen_unroll_first_instruction;
@@ -62,6 +272,215 @@ duplicate_uop(ir_data_t *ir, uop_t *uop, int offset)
     }
 }
 
+/*Constant propagation state. A register version is known to hold a constant
+  if it was written by UOP_MOV_IMM, or by a uOP folded into one, since the last
+  barrier or jump destination. The constant only describes the part of the
+  register that was written, so it is only used for reads of the same size.*/
+static struct {
+    uint32_t value;
+    uint16_t version;
+    uint16_t gen;
+    int      size;
+} reg_const[IREG_COUNT];
+static uint16_t reg_const_gen;
+
+static void
+const_invalidate_all(void)
+{
+    reg_const_gen++;
+    if (!reg_const_gen) {
+        memset(reg_const, 0, sizeof(reg_const));
+        reg_const_gen = 1;
+    }
+}
+
+static int
+const_get(ir_reg_t ir_reg, uint32_t *value)
+{
+    int reg = IREG_GET_REG(ir_reg.reg);
+
+    if (ir_reg_is_invalid(ir_reg) || (reg_const[reg].gen != reg_const_gen) ||
+        (reg_const[reg].version != ir_reg.version) || (reg_const[reg].size != IREG_GET_SIZE(ir_reg.reg)))
+        return 0;
+
+    *value = reg_const[reg].value;
+    return 1;
+}
+
+static void
+const_set(ir_reg_t ir_reg, uint32_t value)
+{
+    int reg = IREG_GET_REG(ir_reg.reg);
+
+    reg_const[reg].value   = value;
+    reg_const[reg].version = ir_reg.version;
+    reg_const[reg].gen     = reg_const_gen;
+    reg_const[reg].size    = IREG_GET_SIZE(ir_reg.reg);
+}
+
+/*Drop one read of a register version, queueing its producer for removal if
+  nothing reads it any more. Same conditions as codegen_reg_write().*/
+static void
+const_drop_read(ir_data_t *ir, ir_reg_t ir_reg)
+{
+    int            reg  = IREG_GET_REG(ir_reg.reg);
+    reg_version_t *regv = &reg_version[reg][ir_reg.version];
+
+    regv->refcount--;
+    if (regv->refcount || (reg <= IREG_EBX) || !ir_reg.version || (regv->flags & (REG_FLAGS_REQUIRED | REG_FLAGS_DEAD)))
+        return;
+
+    /*A non-native size write of the next version depends on this one.*/
+    if (ir_reg.version < reg_last_version[reg]) {
+        const reg_version_t *next = &reg_version[reg][ir_reg.version + 1];
+
+        if (!reg_is_native_size(ir->uops[next->parent_uop].dest_reg_a))
+            return;
+    }
+
+    add_to_dead_list(regv, reg, ir_reg.version);
+}
+
+static int
+const_same_size(ir_reg_t a, ir_reg_t b)
+{
+    return IREG_GET_SIZE(a.reg) == IREG_GET_SIZE(b.reg);
+}
+
+static uint32_t
+const_mask(ir_reg_t ir_reg, uint32_t value)
+{
+    switch (IREG_GET_SIZE(ir_reg.reg)) {
+        case IREG_SIZE_W:
+            return value & 0xffff;
+        case IREG_SIZE_B:
+            return value & 0xff;
+        default:
+            return value;
+    }
+}
+
+/*Rewrite uOPs whose register operands are known constants into their
+  immediate forms, and fold fully constant 32-bit operations into UOP_MOV_IMM.
+  Registers that are no longer read are left to the dead list, so that their
+  producers are removed by codegen_reg_process_dead_list().*/
+static void
+codegen_ir_propagate_constants(ir_data_t *ir)
+{
+    uint8_t  jump_dest[UOP_NR_MAX];
+    uint32_t value;
+    int      c;
+
+    memset(jump_dest, 0, ir->wr_pos);
+    for (c = 0; c < ir->wr_pos; c++) {
+        const uop_t *uop = &ir->uops[c];
+
+        if ((uop->type & UOP_TYPE_JUMP) && (uop->jump_dest_uop >= 0) && (uop->jump_dest_uop < ir->wr_pos))
+            jump_dest[uop->jump_dest_uop] = 1;
+    }
+
+    const_invalidate_all();
+
+    for (c = 0; c < ir->wr_pos; c++) {
+        uop_t *uop = &ir->uops[c];
+
+        /*Registers are reloaded from memory after these, and helpers may have
+          changed them.*/
+        if (jump_dest[c] || (uop->type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_JUMP_DEST)))
+            const_invalidate_all();
+
+        switch (uop->type) {
+            case UOP_MOV_IMM:
+                if (reg_can_hold_imm(uop->dest_reg_a))
+                    const_set(uop->dest_reg_a, const_mask(uop->dest_reg_a, uop->imm_data));
+                continue;
+
+            case UOP_MOV:
+                if (reg_can_hold_imm(uop->dest_reg_a) && const_same_size(uop->dest_reg_a, uop->src_reg_a) &&
+                    const_get(uop->src_reg_a, &value)) {
+                    const_drop_read(ir, uop->src_reg_a);
+                    uop->type      = UOP_MOV_IMM;
+                    uop->src_reg_a = invalid_ir_reg;
+                    uop->imm_data  = value;
+                    const_set(uop->dest_reg_a, value);
+                    codegen_stats.ir_folded++;
+                }
+                continue;
+
+            case UOP_ADD_IMM:
+            case UOP_SUB_IMM:
+            case UOP_AND_IMM:
+            case UOP_OR_IMM:
+            case UOP_XOR_IMM:
+                if ((IREG_GET_SIZE(uop->dest_reg_a.reg) == IREG_SIZE_L) && reg_can_hold_imm(uop->dest_reg_a) &&
+                    const_same_size(uop->dest_reg_a, uop->src_reg_a) && const_get(uop->src_reg_a, &value)) {
+                    uint32_t imm = uop->imm_data;
+
+                    if (uop->type == UOP_ADD_IMM)
+                        value += imm;
+                    else if (uop->type == UOP_SUB_IMM)
+                        value -= imm;
+                    else if (uop->type == UOP_AND_IMM)
+                        value &= imm;
+                    else if (uop->type == UOP_OR_IMM)
+                        value |= imm;
+                    else
+                        value ^= imm;
+
+                    const_drop_read(ir, uop->src_reg_a);
+                    uop->type      = UOP_MOV_IMM;
+                    uop->src_reg_a = invalid_ir_reg;
+                    uop->imm_data  = value;
+                    const_set(uop->dest_reg_a, value);
+                    codegen_stats.ir_folded++;
+                }
+                continue;
+
+            case UOP_ADD:
+            case UOP_SUB:
+            case UOP_AND:
+            case UOP_OR:
+            case UOP_XOR:
+                if (!reg_can_hold_imm(uop->dest_reg_a) || !const_same_size(uop->dest_reg_a, uop->src_reg_a) ||
+                    !const_same_size(uop->dest_reg_a, uop->src_reg_b))
+                    continue;
+
+                /*The immediate forms operate on the destination in place on
+                  some backends, so the register operand that is kept must be
+                  the destination. Commutative operations can take the
+                  constant from either side.*/
+                if ((uop->src_reg_a.reg != uop->dest_reg_a.reg) || !const_get(uop->src_reg_b, &value)) {
+                    ir_reg_t tmp = uop->src_reg_a;
+
+                    if ((uop->type == UOP_SUB) || (uop->src_reg_b.reg != uop->dest_reg_a.reg) ||
+                        !const_get(uop->src_reg_a, &value))
+                        continue;
+                    uop->src_reg_a = uop->src_reg_b;
+                    uop->src_reg_b = tmp;
+                }
+
+                const_drop_read(ir, uop->src_reg_b);
+                uop->src_reg_b = invalid_ir_reg;
+                uop->imm_data  = value;
+                if (uop->type == UOP_ADD)
+                    uop->type = UOP_ADD_IMM;
+                else if (uop->type == UOP_SUB)
+                    uop->type = UOP_SUB_IMM;
+                else if (uop->type == UOP_AND)
+                    uop->type = UOP_AND_IMM;
+                else if (uop->type == UOP_OR)
+                    uop->type = UOP_OR_IMM;
+                else
+                    uop->type = UOP_XOR_IMM;
+                codegen_stats.ir_folded++;
+                continue;
+
+            default:
+                continue;
+        }
+    }
+}
+
 void
 codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
 {
@@ -84,8 +503,15 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
         }
     }
 
+    codegen_stats.ir_uops += ir->wr_pos;
+    codegen_slice_uops += ir->wr_pos;
+    codegen_ir_dump(ir, block, "generated");
+
     codegen_reg_mark_as_required();
+    codegen_ir_propagate_constants(ir);
     codegen_reg_process_dead_list(ir);
+
+    codegen_ir_dump(ir, block, "optimised");
     block_write_data = codeblock_allocator_get_ptr(block->head_mem_block);
     block_pos        = 0;
     codegen_backend_prologue(block);
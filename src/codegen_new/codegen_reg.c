@@ -231,6 +231,22 @@ reg_is_native_size(ir_reg_t ir_reg)
     return native_requested_sizes[native_size][requested_size >> IREG_SIZE_SHIFT];
 }
 
+/*Returns 1 if UOP_MOV_IMM can write this register, ie it is a 32-bit, 16-bit or
+  low 8-bit view of an integer register.*/
+int
+reg_can_hold_imm(ir_reg_t ir_reg)
+{
+    int native_size    = ireg_data[IREG_GET_REG(ir_reg.reg)].native_size;
+    int requested_size = IREG_GET_SIZE(ir_reg.reg);
+
+    if (ir_reg_is_invalid(ir_reg) || (ireg_data[IREG_GET_REG(ir_reg.reg)].type != REG_INTEGER))
+        return 0;
+    if ((native_size != REG_BYTE) && (native_size != REG_WORD) && (native_size != REG_DWORD))
+        return 0;
+
+    return (requested_size == IREG_SIZE_L) || (requested_size == IREG_SIZE_W) || (requested_size == IREG_SIZE_B);
+}
+
 void
 codegen_check_regs(void)
 {
@@ -905,6 +921,7 @@ codegen_reg_process_dead_list(ir_data_t *ir)
                     add_to_dead_list(src_regv, IREG_GET_REG(uop->src_reg_c.reg), uop->src_reg_c.version);
             }
             regv->flags |= REG_FLAGS_DEAD;
+            codegen_stats.ir_dead++;
         }
 
         reg_dead_list = regv->next;
@@ -60,6 +60,7 @@
 #include <86box/keyboard.h>
 #include <86box/serial_passthrough.h>
 #include <86box/machine.h>
+#include <86box/mem.h>
 #include <86box/mouse.h>
 #include <86box/thread.h>
 #include <86box/network.h>
@@ -207,6 +208,8 @@ load_general(void)
     video_grayscale  = ini_section_get_int(cat, "video_grayscale", 0);
     video_graytype   = ini_section_get_int(cat, "video_graytype", 0);
 
+    vid_render_thread = !!ini_section_get_int(cat, "vid_render_thread", 0);
+
     force_10ms = !!ini_section_get_int(cat, "force_10ms", 0);
 
     rctrl_is_lalt = ini_section_get_int(cat, "rctrl_is_lalt", 0);
@@ -476,7 +479,32 @@ load_machine(void)
     if (mem_size > machine_get_max_ram(machine))
         mem_size = machine_get_max_ram(machine);
 
+    /*
+     * The golden RAM image is only written by a save state, so it can
+     * only be produced on machines whose devices all support them.
+     */
+    p = ini_section_get_string(cat, "ram_image", "");
+    memset(mem_ram_image, 0x00, sizeof(mem_ram_image));
+    if (p[0] != 0x00) {
+        if (path_abs((char *) p))
+            strncpy(mem_ram_image, p, sizeof(mem_ram_image) - 1);
+        else
+            path_append_filename(mem_ram_image, usr_path, p);
+        path_normalize(mem_ram_image);
+    }
+
+    /* The soft TLB size must be a power of two. */
+    c = ini_section_get_int(cat, "tlb_size", 256);
+    for (cachesize = 64; (cachesize < TLB_SIZE_MAX) && ((cachesize << 1) <= c); cachesize <<= 1)
+        ;
+
     cpu_use_dynarec = !!ini_section_get_int(cat, "cpu_use_dynarec", 0);
+    dynarec_cache_size = ini_section_get_int(cat, "dynarec_cache_size", 0);
+    if (dynarec_cache_size < 0)
+        dynarec_cache_size = 0;
+    dynarec_compile_budget = ini_section_get_int(cat, "dynarec_compile_budget", 0);
+    if (dynarec_compile_budget < 0)
+        dynarec_compile_budget = 0;
     fpu_softfloat = !!ini_section_get_int(cat, "fpu_softfloat", 0);
     if ((fpu_type != FPU_NONE) && machine_has_flags(machine, MACHINE_SOFTFLOAT_ONLY))
         fpu_softfloat = 1;
@@ -1190,6 +1218,13 @@ load_hard_disks(void)
     uint32_t      board = 0;
     uint32_t      dev = 0;
 
+    hdd_write_back = !!ini_section_get_int(cat, "write_back", 0);
+    hdd_cache_size = ini_section_get_int(cat, "cache_size", 0);
+    if (hdd_cache_size < 0)
+        hdd_cache_size = 0;
+    else if (hdd_cache_size > 2047)
+        hdd_cache_size = 2047;
+
     memset(temp, '\0', sizeof(temp));
     for (uint8_t c = 0; c < HDD_NUM; c++) {
         sprintf(temp, "hdd_%02i_parameters", c + 1);
@@ -1351,6 +1386,17 @@ load_hard_disks(void)
         p = ini_section_get_string(cat, temp, "");
         strncpy(hdd[c].vhd_parent, p, sizeof(hdd[c].vhd_parent) - 1);
 
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        p = ini_section_get_string(cat, temp, "");
+        memset(hdd[c].overlay, 0x00, sizeof(hdd[c].overlay));
+        if (p[0] != 0x00) {
+            if (path_abs(p))
+                strncpy(hdd[c].overlay, p, sizeof(hdd[c].overlay) - 1);
+            else
+                path_append_filename(hdd[c].overlay, usr_path, p);
+            path_normalize(hdd[c].overlay);
+        }
+
         /* If disk is empty or invalid, mark it for deletion. */
         if (!hdd_is_valid(c)) {
             sprintf(temp, "hdd_%02i_parameters", c + 1);
@@ -2204,6 +2250,8 @@ config_load(void)
         /* Unmute the CD audio on the first CD-ROM drive. */
         cdrom[0].sound_on = 1;
         mem_size          = 64;
+        mem_ram_image[0]  = 0x00;
+        cachesize         = 256;
         isartc_type       = 0;
         for (i = 0; i < ISAROM_MAX; i++)
             isarom_type[i] = 0;
@@ -2409,6 +2457,11 @@ save_general(void)
     else
         ini_section_set_int(cat, "enable_overscan", enable_overscan);
 
+    if (vid_render_thread == 0)
+        ini_section_delete_var(cat, "vid_render_thread");
+    else
+        ini_section_set_int(cat, "vid_render_thread", vid_render_thread);
+
     if (vid_cga_contrast == 0)
         ini_section_delete_var(cat, "vid_cga_contrast");
     else
@@ -2597,8 +2650,30 @@ save_machine(void)
        to display it without having the actual machine table. */
     ini_section_set_int(cat, "mem_size", mem_size);
 
+    if (mem_ram_image[0] == 0x00)
+        ini_section_delete_var(cat, "ram_image");
+    else if (!strnicmp(mem_ram_image, usr_path, strlen(usr_path)))
+        ini_section_set_string(cat, "ram_image", &mem_ram_image[strlen(usr_path)]);
+    else
+        ini_section_set_string(cat, "ram_image", mem_ram_image);
+
+    if (cachesize == 256)
+        ini_section_delete_var(cat, "tlb_size");
+    else
+        ini_section_set_int(cat, "tlb_size", cachesize);
+
     ini_section_set_int(cat, "cpu_use_dynarec", cpu_use_dynarec);
 
+    if (dynarec_cache_size == 0)
+        ini_section_delete_var(cat, "dynarec_cache_size");
+    else
+        ini_section_set_int(cat, "dynarec_cache_size", dynarec_cache_size);
+
+    if (dynarec_compile_budget == 0)
+        ini_section_delete_var(cat, "dynarec_compile_budget");
+    else
+        ini_section_set_int(cat, "dynarec_compile_budget", dynarec_compile_budget);
+
     if (fpu_softfloat == 0)
         ini_section_delete_var(cat, "fpu_softfloat");
     else
@@ -3397,6 +3472,16 @@ save_hard_disks(void)
         } else
             ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        if (hdd_is_valid(c) && hdd[c].overlay[0]) {
+            path_normalize(hdd[c].overlay);
+            if (!strnicmp(hdd[c].overlay, usr_path, strlen(usr_path)))
+                ini_section_set_string(cat, temp, &hdd[c].overlay[strlen(usr_path)]);
+            else
+                ini_section_set_string(cat, temp, hdd[c].overlay);
+        } else
+            ini_section_delete_var(cat, temp);
+
         sprintf(temp, "hdd_%02i_speed", c + 1);
         if (!hdd_is_valid(c) ||
             ((hdd[c].bus_type != HDD_BUS_ESDI) && (hdd[c].bus_type != HDD_BUS_IDE) &&
@@ -3406,6 +3491,16 @@ save_hard_disks(void)
             ini_section_set_string(cat, temp, hdd_preset_get_internal_name(hdd[c].speed_preset));
     }
 
+    if (hdd_write_back)
+        ini_section_set_int(cat, "write_back", hdd_write_back);
+    else
+        ini_section_delete_var(cat, "write_back");
+
+    if (hdd_cache_size)
+        ini_section_set_int(cat, "cache_size", hdd_cache_size);
+    else
+        ini_section_delete_var(cat, "cache_size");
+
     ini_delete_section_if_empty(config, cat);
 }
 
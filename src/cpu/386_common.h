@@ -310,11 +310,27 @@ int checkio(uint32_t port, int mask);
     }
 
 #ifdef OPS_286_386
-/* TODO: Introduce functions to read exec. */
+/* Host pointer to the code page containing a, or NULL if the fetch has to go
+   through the full read path (breakpoints, non-RAM/ROM memory). */
+static __inline uint8_t *
+fetch_2386_ptr(uint32_t a)
+{
+    if (((a >> 12) == fetch_2386_page) && (fetch_2386_gen == mem_exec_gen) &&
+        !cpu_flush_pending && !(dr[7] & 0x000000ff) && (fetch_2386_user || (CPL != 3)))
+        return fetch_2386_base;
+
+    return fetch_2386_fill(a);
+}
+
 static __inline uint8_t
 fastreadb(uint32_t a)
 {
-    uint8_t ret;
+    uint8_t  ret;
+    uint8_t *p;
+
+    if (!cpu_state.abrt && ((p = fetch_2386_ptr(a)) != NULL))
+        return p[a & 0xfff];
+
     read_type = 1;
     ret = readmembl_2386(a);
     read_type = 4;
@@ -327,6 +343,14 @@ static __inline uint16_t
 fastreadw(uint32_t a)
 {
     uint16_t ret;
+    uint8_t *p;
+
+    if (((a & 0xfff) <= 0xffe) && !cpu_state.abrt && ((p = fetch_2386_ptr(a)) != NULL)) {
+        if ((a & 1) && (!cpu_cyrix_alignment || (a & 7) == 7))
+            cycles -= timing_misaligned;
+        return *(uint16_t *) &p[a & 0xfff];
+    }
+
     read_type = 1;
     ret = readmemwl_2386(a);
     read_type = 4;
@@ -339,6 +363,14 @@ static __inline uint32_t
 fastreadl(uint32_t a)
 {
     uint32_t ret;
+    uint8_t *p;
+
+    if (((a & 0xfff) <= 0xffc) && !cpu_state.abrt && ((p = fetch_2386_ptr(a)) != NULL)) {
+        if ((a & 3) && (!cpu_cyrix_alignment || (a & 7) > 4))
+            cycles -= timing_misaligned;
+        return *(uint32_t *) &p[a & 0xfff];
+    }
+
     read_type = 1;
     ret = readmemll_2386(a);
     read_type = 4;
@@ -456,11 +488,8 @@ fastreadw_fetch(uint32_t a)
             ret |= ((uint16_t) fastreadb(a + 1) << 8);
     } else if (cpu_state.abrt)
         ret = 0;
-    else {
-        read_type = 1;
-        ret = readmemwl_2386(a);
-        read_type = 4;
-    }
+    else
+        ret = fastreadw(a);
     cpu_old_paging = 0;
 
     return ret;
@@ -478,11 +507,9 @@ fastreadl_fetch(uint32_t a)
     } else if (cpu_state.abrt)
         ret = 0;
     else {
-        read_type = 1;
         cpu_old_paging = (cpu_flush_pending == 2);
-        ret = readmemll_2386(a);
+        ret = fastreadl(a);
         cpu_old_paging = 0;
-        read_type = 4;
     }
 
     return ret;
@@ -29,9 +29,11 @@
 #include <86box/fdd.h>
 #include <86box/fdc.h>
 #include <86box/machine.h>
+#include <86box/plat.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
 #include <86box/gdbstub.h>
+#include <86box/profiler.h>
 #ifdef USE_DYNAREC
 #    include "codegen.h"
 #    ifdef USE_NEW_DYNAREC
@@ -386,6 +388,61 @@ block_ended:
     cpu_end_block_after_ins = 0;
 }
 
+#    ifdef USE_NEW_DYNAREC
+/* Last compiled block run by the dispatcher, used to learn chain links. */
+static codeblock_t *chain_last = NULL;
+
+/* Returns the block to run straight after prev without going back to the
+   main loop, or NULL if the main loop has to look at the CPU state first. */
+static __inline codeblock_t *
+exec386_dynarec_chain(codeblock_t *prev)
+{
+#        ifdef USE_GDBSTUB
+    return NULL;
+#        else
+    codeblock_t *block;
+    uint32_t     phys_addr;
+
+    if (prev->chain_next == BLOCK_INVALID)
+        return NULL;
+
+    /* Aborts, resets, pending interrupts and the like. */
+    if (cpu_state.abrt || cpu_init || x86_was_reset || new_ne || smi_line || trap || cpu_end_block_after_ins ||
+        (nmi && nmi_enable && nmi_mask) || ((cpu_state.flags & I_FLAG) && pic.int_pending))
+        return NULL;
+
+    /* End of the time slice, interim timer processing or a timer due. */
+    if ((cycles <= 0) || (tsc != tsc_old) ||
+        TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) (tsc_old + (cycles_old - cycles))))
+        return NULL;
+
+    if (!CACHE_ON() || cpu_override_dynarec)
+        return NULL;
+
+    block = &codeblock[prev->chain_next];
+    if ((block->pc != cs + cpu_state.pc) || ((block->pc ^ prev->pc) & ~0xfff))
+        return NULL;
+
+    phys_addr = get_phys(cs + cpu_state.pc);
+    if (cpu_state.abrt)
+        return NULL;
+
+    /* Same checks as the hash lookup path, anything that would need the
+       block flushed or recompiled is left to the dispatcher. */
+    if ((block->_cs != cs) || (block->phys != phys_addr) || ((block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) ||
+        ((block->status & cpu_cur_status & CPU_STATUS_MASK) != (cpu_cur_status & CPU_STATUS_MASK)))
+        return NULL;
+    if (!(block->flags & CODEBLOCK_WAS_RECOMPILED) || (block->flags & CODEBLOCK_IN_DIRTY_LIST) ||
+        block->page_mask2 || (block->page_mask & *block->dirty_mask))
+        return NULL;
+    if ((block->flags & CODEBLOCK_STATIC_TOP) && (block->TOP != (cpu_state.TOP & 7)))
+        return NULL;
+
+    return block;
+#        endif
+}
+#    endif
+
 #if defined(__linux__) && !defined(__clang__) && defined(USE_NEW_DYNAREC)
 static inline void __attribute__((optimize("O2")))
 #else
@@ -402,6 +459,12 @@ exec386_dynarec_dyn(void)
     codeblock_t *block = codeblock_hash[hash];
 #    endif
     int valid_block = 0;
+#    ifdef USE_NEW_DYNAREC
+    codeblock_t *prev_block = chain_last;
+
+    chain_last = NULL;
+    codegen_stats.dispatches++;
+#    endif
 
 #    ifdef USE_NEW_DYNAREC
     if (!cpu_state.abrt)
@@ -522,21 +585,63 @@ exec386_dynarec_dyn(void)
 #    ifndef USE_NEW_DYNAREC
         codeblock_hash[hash] = block;
 #    endif
+#    ifdef USE_NEW_DYNAREC
+        /* Remember where the previous block went, if it stayed in its page.
+           This includes a block looping back to itself, the link is still
+           validated by exec386_dynarec_chain() before it is taken. */
+        if (prev_block && (prev_block->pc != BLOCK_PC_INVALID) &&
+            !((prev_block->pc ^ block->pc) & ~0xfff))
+            prev_block->chain_next = get_block_nr(block);
+
+        do {
+            code = (void *) &block->data[BLOCK_START];
+
+            if (block->hotness < 0xff)
+                block->hotness++;
+            codegen_stats.hits++;
+            inrecomp = 1;
+            prof_cat = PROF_JIT;
+            code();
+            prof_cat = PROF_INTERP;
+#        ifdef USE_ACYCS
+            acycs = 0;
+#        endif
+            inrecomp = 0;
+
+            chain_last = block;
+            block      = exec386_dynarec_chain(block);
+            if (block)
+                codegen_stats.chained++;
+        } while (block);
+#    else
         inrecomp = 1;
+        prof_cat = PROF_JIT;
         code();
-#    ifdef USE_ACYCS
+        prof_cat = PROF_INTERP;
+#        ifdef USE_ACYCS
         acycs = 0;
-#    endif
+#        endif
         inrecomp = 0;
+#    endif
 
 #    ifndef USE_NEW_DYNAREC
         if (!use32)
             cpu_state.pc &= 0xffff;
 #    endif
-    } else if (valid_block && !cpu_state.abrt) {
+    }
 #    ifdef USE_NEW_DYNAREC
-        start_pc                 = cs + cpu_state.pc;
-        const int max_block_size = (block->flags & CODEBLOCK_BYTE_MASK) ? ((128 - 25) - (start_pc & 0x3f)) : 1000;
+    else if (valid_block && !cpu_state.abrt && codegen_compile_deferred()) {
+        /* Out of compile budget for this slice, interpret the block until
+           the next one. */
+        codegen_stats.deferred++;
+        exec386_dynarec_int();
+    }
+#    endif
+    else if (valid_block && !cpu_state.abrt) {
+#    ifdef USE_NEW_DYNAREC
+        start_pc                     = cs + cpu_state.pc;
+        const int      max_block_size = (block->flags & CODEBLOCK_BYTE_MASK) ? ((128 - 25) - (start_pc & 0x3f)) : 1000;
+        const uint64_t compile_start  = plat_get_us();
 #    else
         start_pc = cpu_state.pc;
 #    endif
@@ -635,6 +740,9 @@ exec386_dynarec_dyn(void)
             codegen_reset();
 
         codegen_in_recompile = 0;
+#    ifdef USE_NEW_DYNAREC
+        codegen_slice_us += plat_get_us() - compile_start;
+#    endif
 #    if defined(__APPLE__) && defined(__aarch64__)
         if (__builtin_available(macOS 11.0, *)) {
             pthread_jit_write_protect_np(1);
@@ -755,6 +863,9 @@ exec386_dynarec(int32_t cycs)
 
     int32_t cyc_period = cycs / (force_10ms ? 2000 : 200); /*5us*/
 
+#    ifdef USE_NEW_DYNAREC
+    codegen_slice_start();
+#    endif
 #    ifdef USE_ACYCS
     acycs = 0;
 #    endif
@@ -276,6 +276,25 @@ clock_end(void)
         timer_process();
 }
 
+/* A halted CPU has nothing to do until the next timer fires, so skip straight
+   to its deadline, within what is left of the current slice. The TSC runs at
+   xt_cpu_multi >> 32 ticks per CPU cycle here. */
+static int
+hlt_idle_cycles(void)
+{
+    int32_t  idle = (int32_t) (timer_target - (uint32_t) tsc);
+    uint32_t mult = (uint32_t) (xt_cpu_multi >> 32ULL);
+
+    if (mult > 1)
+        idle /= (int32_t) mult;
+    if (idle > cycles)
+        idle = cycles;
+    if (idle < 0)
+        idle = 0;
+
+    return idle;
+}
+
 static void
 fetch_and_bus(int c, int bus)
 {
@@ -3655,6 +3674,7 @@ execx86(int cycs)
                         wait_cycs(cycles & 1, 0);
                         check_interrupts(is_nec);
                     } else {
+                        wait_cycs(hlt_idle_cycles(), 0);
                         repeating = 1;
                         completed = 0;
                         clock_end();
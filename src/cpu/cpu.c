@@ -31,6 +31,7 @@
 #include "cpu.h"
 #include "x86.h"
 #include "x87_sf.h"
+#include "x87.h"
 #include <86box/device.h>
 #include <86box/machine.h>
 #include <86box/io.h>
@@ -42,6 +43,7 @@
 #include <86box/pci.h>
 #include <86box/smram.h>
 #include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/gdbstub.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
@@ -4505,3 +4507,74 @@ cpu_update_waitstates(void)
     if (cpu_s->rspeed <= 8000000)
         cpu_rom_prefetch_cycles = cpu_mem_prefetch_cycles;
 }
+
+void
+cpu_savestate(savestate_t *st)
+{
+    x86seg     *segs[6] = { &cpu_state.seg_cs, &cpu_state.seg_ds, &cpu_state.seg_es,
+                            &cpu_state.seg_ss, &cpu_state.seg_fs, &cpu_state.seg_gs };
+    cpu_state_t tmp;
+    uint8_t     ea_seg  = 0xff;
+
+    /* ea_seg is a pointer into cpu_state, store it as an index. */
+    for (uint8_t i = 0; i < 6; i++) {
+        if (cpu_state.ea_seg == segs[i])
+            ea_seg = i;
+    }
+
+    tmp        = cpu_state;
+    tmp.ea_seg = NULL;
+    savestate_var(st, tmp);
+    savestate_var(st, ea_seg);
+
+    if (!st->saving && !st->error) {
+        cpu_state        = tmp;
+        cpu_state.ea_seg = (ea_seg < 6) ? segs[ea_seg] : &cpu_state.seg_ds;
+    }
+
+    savestate_var(st, cr2);
+    savestate_var(st, cr3);
+    savestate_var(st, cr4);
+    savestate_var(st, dr);
+    savestate_var(st, _tr);
+    savestate_var(st, msr);
+    savestate_var(st, gdt);
+    savestate_var(st, ldt);
+    savestate_var(st, idt);
+    savestate_var(st, tr);
+    savestate_var(st, use32);
+    savestate_var(st, stack32);
+    savestate_var(st, oldcpl);
+    savestate_var(st, cpu_cur_status);
+    savestate_var(st, smi_latched);
+    savestate_var(st, smm_in_hlt);
+    savestate_var(st, smi_block);
+    savestate_var(st, nmi);
+    savestate_var(st, nmi_mask);
+    savestate_var(st, amd_efer);
+    savestate_var(st, star);
+    savestate_var(st, cs_msr);
+    savestate_var(st, esp_msr);
+    savestate_var(st, eip_msr);
+    savestate_var(st, ccr0);
+    savestate_var(st, ccr1);
+    savestate_var(st, ccr2);
+    savestate_var(st, ccr3);
+    savestate_var(st, ccr4);
+    savestate_var(st, ccr5);
+    savestate_var(st, ccr6);
+    savestate_var(st, ccr7);
+    savestate_var(st, cpu_cache_int_enabled);
+    savestate_var(st, cpu_cache_ext_enabled);
+    savestate_var(st, fpu_state);
+    savestate_var(st, x87_pc_off);
+    savestate_var(st, x87_op_off);
+    savestate_var(st, x87_pc_seg);
+    savestate_var(st, x87_op_seg);
+    savestate_var(st, tsc);
+
+    if (!st->saving && !st->error) {
+        cpu_update_waitstates();
+        flushmmucache();
+    }
+}
@@ -700,6 +700,21 @@ opF7_l_a32(uint32_t fetchdat)
     return 0;
 }
 
+/* A halted CPU has nothing to do until the next timer fires, so skip straight
+   to its deadline, within what is left of the current slice. */
+static __inline int32_t
+hlt_idle_cycles(void)
+{
+    int32_t idle = (int32_t) (timer_target - (uint32_t) tsc);
+
+    if (idle > cycles)
+        idle = cycles;
+    if (idle < 100)
+        idle = 100;
+
+    return idle;
+}
+
 static int
 opHLT(UNUSED(uint32_t fetchdat))
 {
@@ -710,7 +725,7 @@ opHLT(UNUSED(uint32_t fetchdat))
     if (smi_line)
         enter_smm_check(1);
     else if (!((cpu_state.flags & I_FLAG) && pic.int_pending)) {
-        CLOCK_CYCLES_ALWAYS(100);
+        CLOCK_CYCLES_ALWAYS(hlt_idle_cycles());
         if (!((cpu_state.flags & I_FLAG) && pic.int_pending))
             cpu_state.pc--;
     } else {
@@ -33,6 +33,7 @@
 #include <86box/dma.h>
 #include <86box/ddma.h>
 #include <86box/plat_unused.h>
+#include <86box/savestate.h>
 
 #ifdef ENABLE_DDMA_LOG
 int ddma_do_log = ENABLE_DDMA_LOG;
@@ -159,6 +160,13 @@ ddma_update_io_mapping(ddma_t *dev, int ch, uint8_t base_l, uint8_t base_h, int
         io_sethandler(dev->channels[ch].io_base, 0x10, ddma_reg_read, NULL, NULL, ddma_reg_write, NULL, NULL, &dev->channels[ch]);
 }
 
+static void
+ddma_savestate(UNUSED(void *priv), UNUSED(savestate_t *st))
+{
+    /* The channel registers are the ones of the ISA DMA controller, and
+       the I/O mappings are programmed, and restored, by the southbridge. */
+}
+
 static void
 ddma_close(void *priv)
 {
@@ -194,5 +202,6 @@ const device_t ddma_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = ddma_savestate
 };
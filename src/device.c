@@ -54,7 +54,9 @@
 #include <86box/plat.h>
 #include <86box/rom.h>
 #include <86box/sound.h>
+#include <86box/timer.h>
 #include <86box/ui.h>
+#include <86box/savestate.h>
 
 #define DEVICE_MAX 256 /* max # of devices */
 
@@ -349,6 +351,59 @@ device_reset_all(uint32_t match_flags)
     }
 }
 
+const char *
+device_savestate_unsupported(void)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && (devices[c]->savestate == NULL))
+            return devices[c]->name;
+    }
+
+    return NULL;
+}
+
+void
+device_savestate_all(savestate_t *st)
+{
+    char     name[SAVESTATE_NAME_LEN];
+    char     check[SAVESTATE_NAME_LEN];
+    uint16_t count = 0;
+    uint16_t saved;
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if (devices[c] != NULL)
+            count++;
+    }
+
+    /* The device list has to match exactly, including the order. */
+    saved = count;
+    savestate_var(st, saved);
+    if (!st->error && (saved != count)) {
+        pclog("SAVESTATE: State has %i devices, machine has %i\n", saved, count);
+        st->error = 1;
+    }
+
+    for (uint16_t c = 0; (c < DEVICE_MAX) && !st->error; c++) {
+        if (devices[c] == NULL)
+            continue;
+
+        memset(name, 0x00, sizeof(name));
+        strncpy(name, devices[c]->name, sizeof(name) - 1);
+        memcpy(check, name, sizeof(check));
+        savestate_rw(st, check, sizeof(check));
+        if (!st->error && memcmp(check, name, sizeof(name))) {
+            pclog("SAVESTATE: Expected device \"%s\", found \"%.63s\"\n", name, check);
+            st->error = 1;
+        }
+
+        if (devices[c]->savestate == NULL) {
+            pclog("SAVESTATE: Device \"%s\" does not support save states\n", name);
+            st->error = 1;
+        } else if (!st->error)
+            devices[c]->savestate(device_priv[c], st);
+    }
+}
+
 void *
 device_find_first_priv(uint32_t match_flags)
 {
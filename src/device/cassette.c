@@ -20,6 +20,7 @@
  *****************************************************************************/
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -36,6 +37,7 @@
 #include <86box/timer.h>
 #include <86box/pit.h>
 #include <86box/cassette.h>
+#include <86box/savestate.h>
 
 // #include <lib/console.h>
 
@@ -722,6 +724,33 @@ cassette_init(UNUSED(const device_t *info))
     return cassette;
 }
 
+static void
+cassette_savestate(void *priv, savestate_t *st)
+{
+    pc_cassette_t *cas = (pc_cassette_t *) priv;
+
+    if (cas == NULL)
+        return;
+
+    /* Everything up to the tape file, which comes from the configuration. */
+    savestate_rw(st, cas, offsetof(pc_cassette_t, close));
+    savestate_timer(st, &cas->timer);
+
+    if (st->saving || st->error)
+        return;
+
+    memset(cassette_mode, 0x00, sizeof(cassette_mode));
+    if (cas->save)
+        memcpy(cassette_mode, "save", strlen("save") + 1);
+    else
+        memcpy(cassette_mode, "load", strlen("load") + 1);
+
+    if ((cas->fp != NULL) && fseek(cas->fp, cas->position, SEEK_SET))
+        pclog("CASSETTE: Unable to restore the tape position %lu\n", cas->position);
+
+    ui_sb_update_icon(SB_CASSETTE, !!cas->motor);
+}
+
 const device_t cassette_device = {
     .name          = "IBM PC/PCjr Cassette Device",
     .internal_name = "cassette",
@@ -733,5 +762,6 @@ const device_t cassette_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = cassette_savestate
 };
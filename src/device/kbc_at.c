@@ -14,6 +14,7 @@
  *          Copyright 2023-2025 Miran Grca.
  *          Copyright 2023-2025 EngiNerd.
  */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -39,6 +40,7 @@
 #include <86box/pci.h>
 #include <86box/video.h>
 #include <86box/keyboard.h>
+#include <86box/savestate.h>
 
 #define STAT_PARITY        0x80
 #define STAT_RTIMEOUT      0x40
@@ -2840,6 +2842,28 @@ kbc_at_reset(void *priv)
     dev->status = (dev->status & 0x0f) | (dev->p1 & 0xf0);
 }
 
+static void
+kbc_at_savestate(void *priv, savestate_t *st)
+{
+    atkbc_t *dev = (atkbc_t *) priv;
+
+    /* The bases and IRQs are programmed, and restored, by the chipset. */
+    savestate_rw(st, dev, offsetof(atkbc_t, handler_enable));
+    savestate_timer(st, &dev->kbc_poll_timer);
+    savestate_timer(st, &dev->kbc_dev_poll_timer);
+    savestate_timer(st, &dev->pulse_cb);
+    for (int i = 0; i < 2; i++) {
+        if (kbc_at_ports[i] != NULL)
+            savestate_rw(st, kbc_at_ports[i], offsetof(kbc_at_port_t, priv));
+    }
+    savestate_var(st, fast_reset);
+
+    if (st->saving || st->error)
+        return;
+
+    kbc_at_do_poll = (dev->misc_flags & FLAG_PS2) ? kbc_at_poll_ps2 : kbc_at_poll_at;
+}
+
 static void
 kbc_at_close(void *priv)
 {
@@ -3078,5 +3102,6 @@ const device_t kbc_at_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = kbc_at_savestate
 };
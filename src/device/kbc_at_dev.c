@@ -12,6 +12,7 @@
  *
  *          Copyright 2023-2025 Miran Grca.
  */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -23,6 +24,8 @@
 #include <86box/device.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/keyboard.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 
 #ifdef ENABLE_KBC_AT_DEV_LOG
 int kbc_at_dev_do_log = ENABLE_KBC_AT_DEV_LOG;
@@ -181,6 +184,14 @@ kbc_at_dev_reset(atkbc_dev_t *dev, int do_fa)
         dev->state = DEV_STATE_EXECUTE_BAT;
 }
 
+/* The state shared by all devices on an AT or PS/2 port. */
+void
+kbc_at_dev_savestate(atkbc_dev_t *dev, savestate_t *st)
+{
+    savestate_rw(st, &dev->type, offsetof(atkbc_dev_t, scan) - offsetof(atkbc_dev_t, type));
+    savestate_var(st, *dev->scan);
+}
+
 atkbc_dev_t *
 kbc_at_dev_init(uint8_t inst)
 {
@@ -19,6 +19,7 @@
  *          Copyright 2020 EngiNerd.
  */
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -43,6 +44,7 @@
 #include <86box/snd_speaker.h>
 #include <86box/video.h>
 #include <86box/keyboard.h>
+#include <86box/savestate.h>
 
 #define STAT_PARITY   0x80
 #define STAT_RTIMEOUT 0x40
@@ -685,6 +687,29 @@ kbd_init(const device_t *info)
     return kbd;
 }
 
+static void
+kbd_savestate(void *priv, savestate_t *st)
+{
+    xtkbd_t *kbd = (xtkbd_t *) priv;
+
+    savestate_rw(st, kbd, offsetof(xtkbd_t, send_delay_timer));
+    savestate_timer(st, &kbd->send_delay_timer);
+    savestate_var(st, key_queue);
+    savestate_var(st, key_queue_start);
+    savestate_var(st, key_queue_end);
+    savestate_var(st, keyboard_scan);
+
+    if (st->saving || st->error)
+        return;
+
+    /* Port B is also the PPI output to the speaker. */
+    ppi.pb         = kbd->pb;
+    speaker_gated  = kbd->pb & 1;
+    speaker_enable = kbd->pb & 2;
+    if (speaker_enable)
+        was_speaker_enable = 1;
+}
+
 static void
 kbd_close(void *priv)
 {
@@ -715,7 +740,8 @@ const device_t kbc_pc_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = kbd_savestate
 };
 
 const device_t kbc_pc82_device = {
@@ -729,7 +755,8 @@ const device_t kbc_pc82_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = kbd_savestate
 };
 
 const device_t kbc_pravetz_device = {
@@ -757,7 +784,8 @@ const device_t kbc_xt_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = kbd_savestate
 };
 
 const device_t kbc_xt86_device = {
@@ -771,7 +799,8 @@ const device_t kbc_xt86_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = kbd_savestate
 };
 
 const device_t kbc_xt_compaq_device = {
@@ -26,6 +26,8 @@
 #include <86box/keyboard.h>
 #include <86box/mouse.h>
 #include <86box/machine.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 
 #define FIFO_SIZE      16
 
@@ -6119,6 +6121,34 @@ keyboard_at_init(const device_t *info)
     return dev;
 }
 
+static void
+keyboard_at_savestate(void *priv, savestate_t *st)
+{
+    atkbc_dev_t *dev = (atkbc_dev_t *) priv;
+    uint8_t      leds[4];
+    uint8_t      in_reset = keyboard_get_in_reset();
+
+    keyboard_get_states(&leds[0], &leds[1], &leds[2], &leds[3]);
+
+    /* The pending keys are in the device queue. */
+    kbc_at_dev_savestate(dev, st);
+    savestate_var(st, keyboard_mode);
+    savestate_var(st, keyboard_set3_flags);
+    savestate_var(st, keyboard_set3_all_repeat);
+    savestate_var(st, keyboard_set3_all_break);
+    savestate_var(st, is_special);
+    savestate_var(st, bat_counter);
+    savestate_var(st, leds);
+    savestate_var(st, in_reset);
+
+    if (st->saving || st->error)
+        return;
+
+    keyboard_at_set_scancode_set(dev);
+    keyboard_update_states(leds[0], leds[1], leds[2], leds[3]);
+    keyboard_set_in_reset(in_reset);
+}
+
 static void
 keyboard_at_close(void *priv)
 {
@@ -6199,7 +6229,8 @@ const device_t keyboard_at_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = keyboard_at_config
+    .config        = keyboard_at_config,
+    .savestate     = keyboard_at_savestate
 };
 
 const device_t keyboard_ax_device = {
@@ -6213,7 +6244,8 @@ const device_t keyboard_ax_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = keyboard_at_savestate
 };
 
 const device_t keyboard_ps2_device = {
@@ -6227,7 +6259,8 @@ const device_t keyboard_ps2_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = keyboard_ps2_config
+    .config        = keyboard_ps2_config,
+    .savestate     = keyboard_at_savestate
 };
 
 const device_t keyboard_ps55_device = {
@@ -6241,7 +6274,8 @@ const device_t keyboard_ps55_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = keyboard_at_savestate
 };
 
 const device_t keyboard_at_generic_device = {
@@ -6255,6 +6289,7 @@ const device_t keyboard_at_generic_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = keyboard_at_config
+    .config        = keyboard_at_config,
+    .savestate     = keyboard_at_savestate
 };
 
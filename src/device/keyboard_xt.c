@@ -34,6 +34,8 @@
 #include <86box/m_xt_t1000.h>
 #include <86box/cassette.h>
 #include <86box/keyboard.h>
+#include <86box/plat_unused.h>
+#include <86box/savestate.h>
 
 /*XT keyboard has no escape scancodes, and no scancodes beyond 53*/
 const scancode scancode_xt[512] = {
@@ -572,6 +574,29 @@ kbd_init(const device_t *info)
     return dev;
 }
 
+static void
+kbd_savestate(void *priv, savestate_t *st)
+{
+    kbd_t *dev  = (kbd_t *) priv;
+    int    type = dev->type;
+
+    /* The keyboard has no buffer or command state of its own: the keys in
+       flight are queued, and saved, by the controller. What is left is the
+       layout, which selects the scan code table. */
+    savestate_var(st, type);
+
+    if (st->saving || st->error)
+        return;
+
+    if (type != dev->type) {
+        pclog("SAVESTATE: State was saved with a different keyboard layout\n");
+        st->error = 1;
+        return;
+    }
+
+    keyboard_set_table((dev->type == KBD_83_KEY) ? scancode_xt : scancode_set1);
+}
+
 static void
 kbd_close(void *priv)
 {
@@ -614,5 +639,6 @@ const device_t keyboard_pc_xt_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = keyboard_pc_xt_config
+    .config        = keyboard_pc_xt_config,
+    .savestate     = kbd_savestate
 };
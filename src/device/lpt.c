@@ -2,6 +2,7 @@
    see COPYING for more details
 */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,6 +25,7 @@
 #include <86box/machine.h>
 #include <86box/network.h>
 #include <86box/plat_fallthrough.h>
+#include <86box/savestate.h>
 
 static int    next_inst               = 0;
 static int    lpt_3bc_used            = 0;
@@ -1035,6 +1037,24 @@ lpt_standalone_init(void)
         device_add_inst(&lpt_port_device, next_inst + 1);
 };
 
+static void
+lpt_savestate(void *priv, savestate_t *st)
+{
+    lpt_t *dev = (lpt_t *) priv;
+
+    /* Printers and other attached devices keep state of their own. */
+    if (st->saving && (dev->dt != NULL) && (dev->dt->priv != NULL))
+        savestate_refuse(st, "Parallel Port", "a device is attached to it");
+
+    /* The address and IRQ come from the configuration. */
+    savestate_rw(st, &dev->irq_state, offsetof(lpt_t, addr) - offsetof(lpt_t, irq_state));
+    savestate_var(st, dev->enable_irq);
+    if (dev->fifo != NULL) {
+        savestate_fifo(st, dev->fifo, 16);
+        savestate_timer(st, &dev->fifo_out_timer);
+    }
+}
+
 const device_t lpt_port_device = {
     .name          = "Parallel Port",
     .internal_name = "lpt",
@@ -1046,5 +1066,6 @@ const device_t lpt_port_device = {
     .available     = NULL,
     .speed_changed = lpt_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = lpt_savestate
 };
@@ -17,6 +17,7 @@
  *          Copyright 2017-2020 Fred N. van Kempen.
  */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -35,6 +36,7 @@
 #include <86box/fifo.h>
 #include <86box/serial.h>
 #include <86box/mouse.h>
+#include <86box/savestate.h>
 
 serial_port_t com_ports[SERIAL_MAX];
 
@@ -1030,6 +1032,32 @@ serial_standalone_init(void)
         device_add_inst(&ns8250_device, next_inst + 1);
 };
 
+static void
+serial_savestate(void *priv, savestate_t *st)
+{
+    serial_t *dev = (serial_t *) priv;
+
+    /* Disabled port. */
+    if (dev->rcvr_fifo == NULL)
+        return;
+
+    /* Mice, modems and pass-through keep state of their own. */
+    if (st->saving && (dev->sd->priv != NULL))
+        savestate_refuse(st, "Serial Port", "a device is attached to it");
+
+    /* Everything up to the address, which comes from the configuration. */
+    savestate_rw(st, dev, offsetof(serial_t, dlab));
+    savestate_var(st, dev->dlab);
+    savestate_var(st, dev->out_new);
+    savestate_var(st, dev->thr_empty);
+    savestate_fifo(st, dev->rcvr_fifo, 64);
+    savestate_fifo(st, dev->xmit_fifo, 64);
+    savestate_timer(st, &dev->transmit_timer);
+    savestate_timer(st, &dev->timeout_timer);
+    savestate_timer(st, &dev->receive_timer);
+    savestate_var(st, dev->transmit_period);
+}
+
 const device_t ns8250_device = {
     .name          = "National Semiconductor 8250(-compatible) UART",
     .internal_name = "ns8250",
@@ -1041,7 +1069,8 @@ const device_t ns8250_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns8250_pcjr_3f8_device = {
@@ -1055,7 +1084,8 @@ const device_t ns8250_pcjr_3f8_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns8250_pcjr_2f8_device = {
@@ -1069,7 +1099,8 @@ const device_t ns8250_pcjr_2f8_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns16450_device = {
@@ -1083,7 +1114,8 @@ const device_t ns16450_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns16550_device = {
@@ -1097,7 +1129,8 @@ const device_t ns16550_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns16650_device = {
@@ -1111,7 +1144,8 @@ const device_t ns16650_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns16750_device = {
@@ -1125,7 +1159,8 @@ const device_t ns16750_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns16850_device = {
@@ -1139,7 +1174,8 @@ const device_t ns16850_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
 
 const device_t ns16950_device = {
@@ -1153,5 +1189,6 @@ const device_t ns16950_device = {
     .available     = NULL,
     .speed_changed = serial_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = serial_savestate
 };
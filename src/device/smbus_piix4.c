@@ -13,6 +13,7 @@
  *          Copyright 2020 RichardG.
  */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -25,6 +26,7 @@
 #include <86box/timer.h>
 #include <86box/i2c.h>
 #include <86box/smbus.h>
+#include <86box/savestate.h>
 #include <86box/plat_fallthrough.h>
 
 #ifdef ENABLE_SMBUS_PIIX4_LOG
@@ -369,6 +371,18 @@ smbus_piix4_init(const device_t *info)
     return dev;
 }
 
+static void
+smbus_piix4_savestate(void *priv, savestate_t *st)
+{
+    smbus_piix4_t *dev = (smbus_piix4_t *) priv;
+
+    /* Transactions on the bus complete on the write that starts them, only
+       the completion is delayed. The I/O base and the clock are programmed,
+       and restored, by the southbridge. */
+    savestate_rw(st, &dev->stat, offsetof(smbus_piix4_t, response_timer) - offsetof(smbus_piix4_t, stat));
+    savestate_timer(st, &dev->response_timer);
+}
+
 static void
 smbus_piix4_close(void *priv)
 {
@@ -392,7 +406,8 @@ const device_t piix4_smbus_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = smbus_piix4_savestate
 };
 
 const device_t via_smbus_device = {
@@ -406,5 +421,6 @@ const device_t via_smbus_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = smbus_piix4_savestate
 };
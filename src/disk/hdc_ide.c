@@ -35,6 +35,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/device.h>
 #include <86box/scsi_device.h>
 #include <86box/isapnp.h>
@@ -3256,6 +3257,74 @@ ide_reset(UNUSED(void *priv))
     }
 }
 
+static void
+ide_drive_savestate(ide_t *ide, savestate_t *st)
+{
+    int type    = ide->type;
+    int hdd_num = ide->hdd_num;
+
+    savestate_var(st, type);
+    savestate_var(st, hdd_num);
+
+    if (!st->saving && !st->error && ((type != ide->type) || (hdd_num != ide->hdd_num))) {
+        pclog("SAVESTATE: State was saved with a different IDE drive configuration\n");
+        st->error = 1;
+    }
+
+    savestate_var(st, ide->selected);
+    savestate_var(st, ide->command);
+    savestate_var(st, ide->head);
+    savestate_var(st, ide->params_specified);
+    savestate_var(st, ide->irqstat);
+    savestate_var(st, ide->service);
+    savestate_var(st, ide->blocksize);
+    savestate_var(st, ide->blockcount);
+    savestate_var(st, ide->sector_pos);
+    savestate_var(st, ide->reset);
+    savestate_var(st, ide->mdma_mode);
+    savestate_var(st, ide->do_initial_read);
+    savestate_var(st, ide->cfg_spt);
+    savestate_var(st, ide->cfg_hpc);
+    savestate_var(st, ide->lba_addr);
+    savestate_var(st, ide->interrupt_drq);
+    savestate_var(st, ide->pending_delay);
+    /* A shadow shares the task file of its master, so this is harmless. */
+    savestate_rw(st, ide->tf, sizeof(ide_tf_t));
+    savestate_timer(st, &ide->timer);
+
+    /* The data and sector buffers only matter while a command is under way. */
+    if (ide->tf->atastat & (BUSY_STAT | DRQ_STAT)) {
+        if (ide->buffer != NULL)
+            savestate_rw(st, ide->buffer, 65536 * sizeof(uint16_t));
+        if (ide->sector_buffer != NULL)
+            savestate_rw(st, ide->sector_buffer, 256 * 512);
+    }
+}
+
+static void
+ide_savestate(UNUSED(void *priv), savestate_t *st)
+{
+    ide_board_t *dev;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        dev = ide_boards[i];
+
+        /* The ATAPI device state lives in the SCSI layer, which has no hooks. */
+        if (st->saving && (((dev->ide[0]->type & ~IDE_SHADOW) == IDE_ATAPI) ||
+                           ((dev->ide[1]->type & ~IDE_SHADOW) == IDE_ATAPI)))
+            savestate_refuse(st, "IDE", "an ATAPI device is attached");
+
+        /* The I/O bases are programmed, and restored, by the southbridge. */
+        savestate_var(st, dev->devctl);
+        savestate_var(st, dev->cur_dev);
+        savestate_var(st, dev->diag);
+        savestate_timer(st, &dev->timer);
+
+        for (uint8_t d = 0; d < 2; d++)
+            ide_drive_savestate(dev->ide[d], st);
+    }
+}
+
 /* Close a standalone IDE unit. */
 static void
 ide_close(UNUSED(void *priv))
@@ -3556,7 +3625,8 @@ const device_t ide_pci_2ch_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = ide_savestate
 };
 
 const device_t mcide_device = {
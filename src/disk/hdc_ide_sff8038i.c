@@ -37,6 +37,7 @@
 #include <86box/pci.h>
 #include <86box/pic.h>
 #include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/hdc.h>
 #include <86box/hdc_ide.h>
 #include <86box/hdc_ide_sff8038i.h>
@@ -583,6 +584,24 @@ sff_set_ven_handlers(sff8038i_t *dev, uint8_t (*ven_write)(uint16_t port, uint8_
     dev->priv      = priv;
 }
 
+static void
+sff_savestate(void *priv, savestate_t *st)
+{
+    sff8038i_t *dev = (sff8038i_t *) priv;
+
+    /* The I/O base and the IRQ routing are programmed, and restored, by the southbridge. */
+    savestate_var(st, dev->command);
+    savestate_var(st, dev->status);
+    savestate_var(st, dev->ptr0);
+    savestate_var(st, dev->dma_mode);
+    savestate_var(st, dev->irq_state);
+    savestate_var(st, dev->ptr);
+    savestate_var(st, dev->ptr_cur);
+    savestate_var(st, dev->addr);
+    savestate_var(st, dev->count);
+    savestate_var(st, dev->eot);
+}
+
 static void
 sff_close(void *priv)
 {
@@ -633,5 +652,6 @@ const device_t sff8038i_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = sff_savestate
 };
@@ -32,6 +32,9 @@
 #define HDD_OVERHEAD_TIME 50.0
 
 hard_disk_t hdd[HDD_NUM];
+int         hdd_write_back = 0;
+int         hdd_cache_size = 0;
+int         hdd_overlay_action = HDD_OVERLAY_NONE;
 
 int
 hdd_init(void)
@@ -15,6 +15,7 @@
  *          Copyright 2017-2018 Fred N. van Kempen.
  */
 #define _GNU_SOURCE
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -32,6 +33,7 @@
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/random.h>
+#include <86box/thread.h>
 #include <86box/hdd.h>
 #include "minivhd/minivhd.h"
 #include "minivhd/internal.h"
@@ -41,6 +43,57 @@
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
 
+/* Largest coalesced write-back request, and most sectors queued before writers wait. */
+#define HDD_IMAGE_REQ_MAX   256
+#define HDD_IMAGE_QUEUE_MAX 16384
+
+typedef struct hdd_image_req_t {
+    uint32_t                sector;
+    uint32_t                count;
+    uint8_t                *data;
+    struct hdd_image_req_t *next;
+} hdd_image_req_t;
+
+/* Overlay files, see hdd_image_overlay_open(). */
+#define HDD_OVERLAY_MAGIC   "86BxOVL\0"
+#define HDD_OVERLAY_VERSION 1
+#define HDD_OVERLAY_BLOCK   128 /* sectors (64 KB) */
+
+typedef struct hdd_overlay_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t block_sectors;
+    uint32_t sectors;
+    uint32_t blocks;
+} hdd_overlay_header_t;
+
+/* Cache blocks are 64 sectors (32 KB). */
+#define HDD_CACHE_BLOCK_SHIFT 6
+#define HDD_CACHE_BLOCK       (1 << HDD_CACHE_BLOCK_SHIFT)
+#define HDD_CACHE_FREE        0xffffffff
+
+typedef struct hdd_image_cache_block_t {
+    uint32_t block; /* HDD_CACHE_FREE if unused */
+    int32_t  hnext; /* hash chain */
+    int32_t  prev;  /* towards the most recently used */
+    int32_t  next;  /* towards the least recently used */
+    uint8_t *data;
+} hdd_image_cache_block_t;
+
+typedef struct hdd_image_cache_t {
+    hdd_image_cache_block_t *blocks;
+    int32_t                 *hash;
+    uint8_t                 *data;
+    uint32_t                 hash_mask;
+    uint32_t                 num;
+    int32_t                  mru;
+    int32_t                  lru;
+    uint32_t                 next_sector; /* used to detect sequential reads */
+    uint64_t                 hits;
+    uint64_t                 misses;
+    uint64_t                 read_ahead;
+} hdd_image_cache_t;
+
 typedef struct hdd_image_t {
     FILE     *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
     MVHDMeta *vhd;  /* Used for HDD_IMAGE_VHD. */
@@ -49,10 +102,34 @@ typedef struct hdd_image_t {
     uint32_t  last_sector;
     uint8_t   type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, or HDD_IMAGE_VHD */
     uint8_t   loaded;
+
+    hdd_image_cache_t *cache;
+
+    /* Overlay, see hdd_image_overlay_open(). */
+    FILE     *ovl_fp;
+    uint32_t *ovl_map;
+    uint32_t  ovl_blocks;
+    uint32_t  ovl_used;
+    uint64_t  ovl_data;
+
+    /* Write-back queue, written out by a per-image thread. */
+    thread_t        *thread;
+    event_t         *wake_event;
+    event_t         *idle_event;
+    mutex_t         *queue_mutex;
+    mutex_t         *file_mutex;
+    hdd_image_req_t *head;
+    hdd_image_req_t *tail;
+    uint32_t         queued;
+    int              stop;
+    volatile int     error;
 } hdd_image_t;
 
 hdd_image_t hdd_images[HDD_NUM];
 
+/* The --overlay action only applies to the first load of each image. */
+static uint8_t hdd_overlay_done[HDD_NUM];
+
 static char  empty_sector[512];
 #ifndef __unix__
 static char *empty_sector_1mb;
@@ -76,6 +153,254 @@ hdd_image_log(const char *fmt, ...)
 #    define hdd_image_log(fmt, ...)
 #endif
 
+/*
+ * Write-back mode.
+ *
+ * Writes to RAW/HDI/HDX images are copied into a queue and written
+ * out by a thread, adjacent requests being coalesced while they wait.
+ * Reads are served from the file with any still queued data laid on
+ * top, so the guest always sees its own writes, and the controllers
+ * keep timing commands with their own timers exactly as before.
+ *
+ * A request that fails to write stays at the head of the queue and is
+ * retried once a second, new writes and drains fail in the meantime.
+ * Queued data is only given up when the image is closed.
+ *
+ * Lock order is file_mutex, then queue_mutex.
+ */
+static void
+hdd_image_thread(void *priv)
+{
+    hdd_image_t     *img = (hdd_image_t *) priv;
+    hdd_image_req_t *req;
+    int              stop;
+    int              failed;
+
+    while (1) {
+        thread_wait_mutex(img->queue_mutex);
+        req = img->head;
+        if (req == NULL) {
+            thread_reset_event(img->wake_event);
+            thread_set_event(img->idle_event);
+            stop = img->stop;
+            thread_release_mutex(img->queue_mutex);
+            if (stop)
+                break;
+            thread_wait_event(img->wake_event, -1);
+            continue;
+        }
+        thread_release_mutex(img->queue_mutex);
+
+        /* The head request is never coalesced into, so its data is stable. */
+        thread_wait_mutex(img->file_mutex);
+        failed = (fseeko64(img->file, ((uint64_t) req->sector << 9LL) + img->base, SEEK_SET) == -1) ||
+                 (fwrite(req->data, 512, req->count, img->file) != req->count) || (fflush(img->file) != 0);
+        thread_release_mutex(img->file_mutex);
+
+        thread_wait_mutex(img->queue_mutex);
+        if (failed) {
+            if (!img->error)
+                pclog("Hard disk image: Error writing back sectors %u-%u, retrying\n",
+                      req->sector, req->sector + req->count - 1);
+            img->error = 1;
+            stop       = img->stop;
+            if (!stop) {
+                /* Let any drain see the error, then retry. */
+                thread_reset_event(img->wake_event);
+                thread_set_event(img->idle_event);
+                thread_release_mutex(img->queue_mutex);
+                thread_wait_event(img->wake_event, 1000);
+                continue;
+            }
+
+            /* Closing, there is nothing left to retry with. */
+            pclog("Hard disk image: Lost %u queued sectors after write-back errors\n", img->queued);
+            while ((req = img->head) != NULL) {
+                img->head = req->next;
+                free(req->data);
+                free(req);
+            }
+            img->tail   = NULL;
+            img->queued = 0;
+            thread_set_event(img->idle_event);
+            thread_release_mutex(img->queue_mutex);
+            break;
+        }
+        img->error = 0;
+
+        img->head = req->next;
+        if (img->head == NULL)
+            img->tail = NULL;
+        img->queued -= req->count;
+        thread_release_mutex(img->queue_mutex);
+
+        free(req->data);
+        free(req);
+    }
+}
+
+static void
+hdd_image_lock(hdd_image_t *img)
+{
+    if (img->file_mutex != NULL)
+        thread_wait_mutex(img->file_mutex);
+}
+
+static void
+hdd_image_unlock(hdd_image_t *img)
+{
+    if (img->file_mutex != NULL)
+        thread_release_mutex(img->file_mutex);
+}
+
+/* Wait for the write-back queue to drain, returns -1 if it is stuck on write errors. */
+static int
+hdd_image_drain(hdd_image_t *img)
+{
+    if (img->thread == NULL)
+        return 0;
+
+    while (1) {
+        thread_wait_mutex(img->queue_mutex);
+        if (img->head == NULL) {
+            thread_release_mutex(img->queue_mutex);
+            return 0;
+        }
+        if (img->error) {
+            thread_release_mutex(img->queue_mutex);
+            return -1;
+        }
+        thread_reset_event(img->idle_event);
+        thread_release_mutex(img->queue_mutex);
+        thread_wait_event(img->idle_event, -1);
+    }
+}
+
+static void
+hdd_image_start(hdd_image_t *img)
+{
+    img->head        = img->tail = NULL;
+    img->queued      = 0;
+    img->stop        = 0;
+    img->error       = 0;
+    img->wake_event  = thread_create_event();
+    img->idle_event  = thread_create_event();
+    img->queue_mutex = thread_create_mutex();
+    img->file_mutex  = thread_create_mutex();
+    img->thread      = thread_create(hdd_image_thread, img);
+}
+
+static void
+hdd_image_stop(hdd_image_t *img)
+{
+    if (img->thread == NULL)
+        return;
+
+    thread_wait_mutex(img->queue_mutex);
+    img->stop = 1;
+    thread_release_mutex(img->queue_mutex);
+    thread_set_event(img->wake_event);
+    thread_wait(img->thread);
+
+    thread_destroy_event(img->wake_event);
+    thread_destroy_event(img->idle_event);
+    thread_close_mutex(img->queue_mutex);
+    thread_close_mutex(img->file_mutex);
+
+    img->thread      = NULL;
+    img->wake_event  = NULL;
+    img->idle_event  = NULL;
+    img->queue_mutex = NULL;
+    img->file_mutex  = NULL;
+    img->stop        = 0;
+
+    if (img->file != NULL)
+        fflush(img->file);
+}
+
+/* Lay the queued writes over data just read from the file, oldest first. */
+static void
+hdd_image_queue_overlay(const hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    const hdd_image_req_t *req;
+    uint32_t               start;
+    uint32_t               end;
+
+    for (req = img->head; req != NULL; req = req->next) {
+        start = (req->sector > sector) ? req->sector : sector;
+        end   = ((req->sector + req->count) < (sector + count)) ? (req->sector + req->count) : (sector + count);
+        if (start < end)
+            memcpy(buffer + ((size_t) (start - sector) << 9), req->data + ((size_t) (start - req->sector) << 9),
+                   (size_t) (end - start) << 9);
+    }
+}
+
+static int
+hdd_image_queue_write(hdd_image_t *img, uint32_t sector, uint32_t count, const uint8_t *buffer)
+{
+    hdd_image_req_t *req;
+    uint8_t         *data;
+
+    if (img->thread == NULL)
+        hdd_image_start(img);
+
+    /* The queue is kept until it can be written, fail new writes meanwhile. */
+    if (img->error) {
+        hdd_image_log("Hard disk image: Write-back error\n");
+        return -1;
+    }
+
+    thread_wait_mutex(img->queue_mutex);
+
+    /* Throttle the guest if the thread cannot keep up. */
+    if (img->queued >= HDD_IMAGE_QUEUE_MAX) {
+        thread_release_mutex(img->queue_mutex);
+        if (hdd_image_drain(img) < 0)
+            return -1;
+        thread_wait_mutex(img->queue_mutex);
+    }
+
+    req = img->tail;
+    if ((req != NULL) && (req != img->head) && (sector == (req->sector + req->count)) &&
+        ((req->count + count) <= HDD_IMAGE_REQ_MAX)) {
+        data = (uint8_t *) realloc(req->data, (size_t) (req->count + count) << 9);
+        if (data != NULL) {
+            memcpy(data + ((size_t) req->count << 9), buffer, (size_t) count << 9);
+            req->data = data;
+            req->count += count;
+            img->queued += count;
+            thread_release_mutex(img->queue_mutex);
+            return 0;
+        }
+    }
+
+    req = (hdd_image_req_t *) calloc(1, sizeof(hdd_image_req_t));
+    if (req != NULL)
+        req->data = (uint8_t *) malloc((size_t) count << 9);
+    if ((req == NULL) || (req->data == NULL)) {
+        thread_release_mutex(img->queue_mutex);
+        free(req);
+        return -1;
+    }
+
+    memcpy(req->data, buffer, (size_t) count << 9);
+    req->sector = sector;
+    req->count  = count;
+    if (img->tail != NULL)
+        img->tail->next = req;
+    else
+        img->head = req;
+    img->tail = req;
+    img->queued += count;
+
+    thread_reset_event(img->idle_event);
+    thread_release_mutex(img->queue_mutex);
+
+    thread_set_event(img->wake_event);
+
+    return 0;
+}
+
 int
 image_is_hdi(const char *s)
 {
@@ -248,8 +573,8 @@ hdd_image_init(void)
         memset(&hdd_images[i], 0, sizeof(hdd_image_t));
 }
 
-int
-hdd_image_load(int id)
+static int
+hdd_image_load_base(int id)
 {
     uint32_t sector_size = 512;
     uint32_t zero        = 0;
@@ -297,14 +622,15 @@ hdd_image_load(int id)
         memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
         goto fail_raw;
     }
-    hdd_images[id].file = plat_fopen(fn, "rb+");
+    /* An image with an overlay is never written to. */
+    hdd_images[id].file = plat_fopen(fn, (hdd[id].overlay[0] != '\0') ? "rb" : "rb+");
     if (hdd_images[id].file == NULL) {
         /* Failed to open existing hard disk image */
         if (errno == ENOENT) {
             /* Failed because it does not exist,
                so try to create new file */
-            if (hdd[id].wp) {
-                hdd_image_log("A write-protected image must exist\n");
+            if (hdd[id].wp || (hdd[id].overlay[0] != '\0')) {
+                hdd_image_log("A write-protected or overlaid image must exist\n");
                 memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
                 goto fail_raw;
             }
@@ -464,7 +790,7 @@ fail_raw:
         } else if (is_vhd[1]) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
-            hdd_images[id].vhd  = mvhd_open(fn, (bool) 0, &vhd_error);
+            hdd_images[id].vhd  = mvhd_open(fn, (bool) (hdd[id].overlay[0] != '\0'), &vhd_error);
             if (hdd_images[id].vhd == NULL) {
                 if (vhd_error == MVHD_ERR_FILE)
                     fatal("hdd_image_load(): VHD: Error opening VHD file '%s': %s\n", fn, strerror(mvhd_errno));
@@ -516,19 +842,23 @@ hdd_image_seek(uint8_t id, uint32_t sector)
 
     hdd_images[id].pos = sector;
     if (hdd_images[id].type != HDD_IMAGE_VHD) {
+        hdd_image_lock(&hdd_images[id]);
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, addr + hdd_images[id].base, SEEK_SET) == -1)) {
+            hdd_image_unlock(&hdd_images[id]);
             hdd_image_log("hdd_image_seek(): Error seeking\n");
             return -1;
         }
+        hdd_image_unlock(&hdd_images[id]);
     }
 
     return 0;
 }
 
-int
-hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_base_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     int    non_transferred_sectors;
+    int    error;
     size_t num_read;
 
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
@@ -538,14 +868,25 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         if (hdd_images[id].vhd->error)
             return -1;
     } else {
+        hdd_image_lock(&hdd_images[id]);
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
+            hdd_image_unlock(&hdd_images[id]);
             hdd_image_log("Hard disk image %i: Read error during seek\n", id);
             return -1;
         }
 
         num_read           = fread(buffer, 512, count, hdd_images[id].file);
         hdd_images[id].pos = sector + num_read;
-        if ((num_read < count) && !feof(hdd_images[id].file))
+        error              = (num_read < count) && !feof(hdd_images[id].file);
+
+        if (hdd_images[id].thread != NULL) {
+            thread_wait_mutex(hdd_images[id].queue_mutex);
+            hdd_image_queue_overlay(&hdd_images[id], sector, count, buffer);
+            thread_release_mutex(hdd_images[id].queue_mutex);
+        }
+        hdd_image_unlock(&hdd_images[id]);
+
+        if (error)
             return -1;
     }
 
@@ -581,8 +922,8 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
-int
-hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_base_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     int    non_transferred_sectors;
     size_t num_write;
@@ -593,8 +934,20 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         hdd_images[id].pos        = sector + count - non_transferred_sectors - 1;
         if (hdd_images[id].vhd->error)
             return -1;
+    } else if (hdd_write_back) {
+        if (!hdd_images[id].file || (hdd_image_queue_write(&hdd_images[id], sector, count, buffer) < 0)) {
+            hdd_image_log("Hard disk image %i: Error queuing write\n", id);
+            return -1;
+        }
+        hdd_images[id].pos = sector + count;
     } else {
+        /* Write-back may have been turned off since the queue was started. */
+        if (hdd_image_drain(&hdd_images[id]) < 0)
+            return -1;
+        hdd_image_lock(&hdd_images[id]);
+
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
+            hdd_image_unlock(&hdd_images[id]);
             hdd_image_log("Hard disk image %i: Write error during seek\n", id);
             return -1;
         }
@@ -602,6 +955,7 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         num_write          = fwrite(buffer, 512, count, hdd_images[id].file);
         hdd_images[id].pos = sector + num_write;
         fflush(hdd_images[id].file);
+        hdd_image_unlock(&hdd_images[id]);
         if (num_write < count)
             return -1;
     }
@@ -609,6 +963,617 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
+/*
+ * Overlay disks.
+ *
+ * When hdd[id].overlay is set, the image itself is opened read-only
+ * and all writes go to the overlay file instead. It starts with a
+ * header and a table giving, for each HDD_OVERLAY_BLOCK-sector block
+ * of the disk, its slot in the overlay (plus 1), or 0 if the block is
+ * still only in the image. Slots are appended as blocks are first
+ * written, so the overlay grows with what the guest writes, and the
+ * same image can back any number of overlays at once.
+ */
+static int
+hdd_image_overlay_create(hdd_image_t *img, const char *fn)
+{
+    hdd_overlay_header_t hdr = { 0 };
+
+    img->ovl_fp = plat_fopen(fn, "wb+");
+    if (img->ovl_fp == NULL)
+        return 0;
+
+    memcpy(hdr.magic, HDD_OVERLAY_MAGIC, sizeof(hdr.magic));
+    hdr.version       = HDD_OVERLAY_VERSION;
+    hdr.block_sectors = HDD_OVERLAY_BLOCK;
+    hdr.sectors       = img->last_sector + 1;
+    hdr.blocks        = img->ovl_blocks;
+
+    memset(img->ovl_map, 0x00, img->ovl_blocks * sizeof(uint32_t));
+    img->ovl_used = 0;
+
+    if ((fwrite(&hdr, 1, sizeof(hdr), img->ovl_fp) != sizeof(hdr)) ||
+        (fwrite(img->ovl_map, sizeof(uint32_t), img->ovl_blocks, img->ovl_fp) != img->ovl_blocks)) {
+        fclose(img->ovl_fp);
+        img->ovl_fp = NULL;
+        return 0;
+    }
+
+    fflush(img->ovl_fp);
+    return 1;
+}
+
+static int
+hdd_image_overlay_open(uint8_t id)
+{
+    hdd_image_t         *img = &hdd_images[id];
+    hdd_overlay_header_t hdr;
+
+    img->ovl_blocks = (img->last_sector + HDD_OVERLAY_BLOCK) / HDD_OVERLAY_BLOCK;
+    img->ovl_data   = (sizeof(hdr) + (img->ovl_blocks * sizeof(uint32_t)) + 511) & ~511ULL;
+    img->ovl_map    = (uint32_t *) calloc(img->ovl_blocks, sizeof(uint32_t));
+    if (img->ovl_map == NULL)
+        return 0;
+
+    img->ovl_fp = plat_fopen(hdd[id].overlay, "rb+");
+    if (img->ovl_fp == NULL) {
+        if (!hdd_image_overlay_create(img, hdd[id].overlay)) {
+            pclog("Hard disk image %i: Unable to create overlay \"%s\"\n", id, hdd[id].overlay);
+            return 0;
+        }
+        return 1;
+    }
+
+    if ((fread(&hdr, 1, sizeof(hdr), img->ovl_fp) != sizeof(hdr)) ||
+        memcmp(hdr.magic, HDD_OVERLAY_MAGIC, sizeof(hdr.magic)) || (hdr.version != HDD_OVERLAY_VERSION) ||
+        (hdr.block_sectors != HDD_OVERLAY_BLOCK) || (hdr.sectors != (img->last_sector + 1)) ||
+        (hdr.blocks != img->ovl_blocks) ||
+        (fread(img->ovl_map, sizeof(uint32_t), img->ovl_blocks, img->ovl_fp) != img->ovl_blocks)) {
+        pclog("Hard disk image %i: \"%s\" is not an overlay of this image\n", id, hdd[id].overlay);
+        return 0;
+    }
+
+    img->ovl_used = 0;
+    for (uint32_t i = 0; i < img->ovl_blocks; i++) {
+        if (img->ovl_map[i] > img->ovl_used)
+            img->ovl_used = img->ovl_map[i];
+    }
+
+    return 1;
+}
+
+static void
+hdd_image_overlay_close(hdd_image_t *img)
+{
+    if (img->ovl_fp != NULL) {
+        fclose(img->ovl_fp);
+        img->ovl_fp = NULL;
+    }
+
+    free(img->ovl_map);
+    img->ovl_map = NULL;
+}
+
+static uint64_t
+hdd_image_overlay_offset(const hdd_image_t *img, uint32_t slot, uint32_t off)
+{
+    return img->ovl_data + ((uint64_t) (slot - 1) * (HDD_OVERLAY_BLOCK << 9)) + ((uint64_t) off << 9);
+}
+
+/* Copy a block from the image into a new slot at the end of the overlay. */
+static int
+hdd_image_overlay_alloc(uint8_t id, uint32_t block)
+{
+    hdd_image_t    *img   = &hdd_images[id];
+    static uint8_t  buf[HDD_OVERLAY_BLOCK << 9];
+    uint32_t        first = block * HDD_OVERLAY_BLOCK;
+    uint32_t        count = HDD_OVERLAY_BLOCK;
+    uint32_t        slot  = img->ovl_used + 1;
+
+    if ((img->last_sector - first) < count)
+        count = img->last_sector - first + 1;
+
+    memset(buf, 0x00, sizeof(buf));
+    if (hdd_image_base_read(id, first, count, buf) < 0)
+        return -1;
+
+    if ((fseeko64(img->ovl_fp, hdd_image_overlay_offset(img, slot, 0), SEEK_SET) == -1) ||
+        (fwrite(buf, 1, sizeof(buf), img->ovl_fp) != sizeof(buf)) ||
+        (fflush(img->ovl_fp) != 0))
+        return -1;
+
+    /* Only point the table at the slot once its contents are there. */
+    if ((fseeko64(img->ovl_fp, sizeof(hdd_overlay_header_t) + (block * sizeof(uint32_t)), SEEK_SET) == -1) ||
+        (fwrite(&slot, 1, sizeof(uint32_t), img->ovl_fp) != sizeof(uint32_t)))
+        return -1;
+
+    img->ovl_map[block] = slot;
+    img->ovl_used       = slot;
+
+    return 0;
+}
+
+static int
+hdd_image_overlay_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_t *img = &hdd_images[id];
+    uint32_t     slot;
+    uint32_t     off;
+    uint32_t     n;
+
+    while (count) {
+        slot = img->ovl_map[sector / HDD_OVERLAY_BLOCK];
+        off  = sector % HDD_OVERLAY_BLOCK;
+        n    = HDD_OVERLAY_BLOCK - off;
+        if (n > count)
+            n = count;
+
+        if (slot == 0) {
+            if (hdd_image_base_read(id, sector, n, buffer) < 0)
+                return -1;
+        } else if ((fseeko64(img->ovl_fp, hdd_image_overlay_offset(img, slot, off), SEEK_SET) == -1) ||
+                   (fread(buffer, 512, n, img->ovl_fp) != n))
+            return -1;
+
+        sector += n;
+        count -= n;
+        buffer += (n << 9);
+    }
+
+    img->pos = sector;
+
+    return 0;
+}
+
+static int
+hdd_image_overlay_write(uint8_t id, uint32_t sector, uint32_t count, const uint8_t *buffer)
+{
+    hdd_image_t *img = &hdd_images[id];
+    uint32_t     block;
+    uint32_t     off;
+    uint32_t     n;
+
+    while (count) {
+        block = sector / HDD_OVERLAY_BLOCK;
+        off   = sector % HDD_OVERLAY_BLOCK;
+        n     = HDD_OVERLAY_BLOCK - off;
+        if (n > count)
+            n = count;
+
+        if ((img->ovl_map[block] == 0) && (hdd_image_overlay_alloc(id, block) < 0))
+            return -1;
+
+        if ((fseeko64(img->ovl_fp, hdd_image_overlay_offset(img, img->ovl_map[block], off), SEEK_SET) == -1) ||
+            (fwrite(buffer, 512, n, img->ovl_fp) != n))
+            return -1;
+
+        sector += n;
+        count -= n;
+        buffer += (n << 9);
+    }
+
+    img->pos = sector;
+
+    if (!hdd_write_back)
+        fflush(img->ovl_fp);
+
+    return 0;
+}
+
+/* Write every block in the overlay back to the image, then empty the overlay. */
+static int
+hdd_image_overlay_commit(uint8_t id)
+{
+    hdd_image_t    *img = &hdd_images[id];
+    static uint8_t  buf[HDD_OVERLAY_BLOCK << 9];
+    uint32_t        first;
+    uint32_t        count;
+    int             vhd_error = 0;
+    int             ret       = 0;
+
+    /* The image was opened read-only. */
+    if (img->type == HDD_IMAGE_VHD) {
+        mvhd_close(img->vhd);
+        img->vhd = mvhd_open(hdd[id].fn, (bool) 0, &vhd_error);
+        if (img->vhd == NULL)
+            fatal("hdd_image_overlay_commit(): VHD: Error reopening '%s' for writing\n", hdd[id].fn);
+    } else {
+        fclose(img->file);
+        img->file = plat_fopen(hdd[id].fn, "rb+");
+        if (img->file == NULL)
+            fatal("hdd_image_overlay_commit(): Error reopening '%s' for writing\n", hdd[id].fn);
+    }
+
+    for (uint32_t i = 0; (ret == 0) && (i < img->ovl_blocks); i++) {
+        if (img->ovl_map[i] == 0)
+            continue;
+
+        first = i * HDD_OVERLAY_BLOCK;
+        count = HDD_OVERLAY_BLOCK;
+        if ((img->last_sector - first) < count)
+            count = img->last_sector - first + 1;
+
+        if ((fseeko64(img->ovl_fp, hdd_image_overlay_offset(img, img->ovl_map[i], 0), SEEK_SET) == -1) ||
+            (fread(buf, 512, count, img->ovl_fp) != count) ||
+            (hdd_image_base_write(id, first, count, buf) < 0))
+            ret = -1;
+    }
+
+    if (hdd_image_drain(img) < 0)
+        ret = -1;
+
+    if (ret == 0)
+        pclog("Hard disk image %i: Committed %u blocks from \"%s\"\n", id, img->ovl_used, hdd[id].overlay);
+
+    return ret;
+}
+
+static int
+hdd_image_overlay_discard(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    fclose(img->ovl_fp);
+    if (!hdd_image_overlay_create(img, hdd[id].overlay))
+        return -1;
+
+    pclog("Hard disk image %i: Discarded \"%s\"\n", id, hdd[id].overlay);
+    return 0;
+}
+
+static int
+hdd_image_do_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (hdd_images[id].ovl_fp != NULL)
+        return hdd_image_overlay_read(id, sector, count, buffer);
+
+    return hdd_image_base_read(id, sector, count, buffer);
+}
+
+static int
+hdd_image_do_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (hdd_images[id].ovl_fp != NULL)
+        return hdd_image_overlay_write(id, sector, count, buffer);
+
+    return hdd_image_base_write(id, sector, count, buffer);
+}
+
+int
+hdd_image_load(int id)
+{
+    int ret;
+
+    hdd_image_overlay_close(&hdd_images[id]);
+
+    ret = hdd_image_load_base(id);
+    if ((ret <= 0) || (hdd[id].overlay[0] == '\0') || !hdd_images[id].loaded)
+        return ret;
+
+    if (!hdd_image_overlay_open(id)) {
+        hdd_image_close(id);
+        return 0;
+    }
+
+    if (hdd_overlay_done[id] || (hdd_overlay_action == HDD_OVERLAY_NONE))
+        return ret;
+
+    /* A hard reset reloads the image, do not commit or discard again. */
+    hdd_overlay_done[id] = 1;
+
+    if (hdd_overlay_action == HDD_OVERLAY_COMMIT) {
+        if (hdd_image_overlay_commit(id) < 0) {
+            pclog("Hard disk image %i: Error committing \"%s\", keeping it\n", id, hdd[id].overlay);
+            return ret;
+        }
+    }
+
+    if (hdd_image_overlay_discard(id) < 0) {
+        hdd_image_close(id);
+        return 0;
+    }
+
+    return ret;
+}
+
+/*
+ * Sector cache.
+ *
+ * Each image can have a cache of HDD_CACHE_BLOCK-sector blocks, sized
+ * by hdd_cache_size, kept in LRU order and looked up through a hash
+ * table. It sits above the image type, so it serves every format the
+ * same way. Writes always go to the image (or its write-back queue)
+ * and update the cached copy, a miss following a sequential read also
+ * reads the next block ahead.
+ */
+static hdd_image_cache_block_t *
+hdd_image_cache_lookup(const hdd_image_cache_t *cache, uint32_t block)
+{
+    int32_t i;
+
+    for (i = cache->hash[block & cache->hash_mask]; i != -1; i = cache->blocks[i].hnext) {
+        if (cache->blocks[i].block == block)
+            return &cache->blocks[i];
+    }
+
+    return NULL;
+}
+
+static void
+hdd_image_cache_unlink(hdd_image_cache_t *cache, hdd_image_cache_block_t *b)
+{
+    if (b->prev != -1)
+        cache->blocks[b->prev].next = b->next;
+    else
+        cache->mru = b->next;
+
+    if (b->next != -1)
+        cache->blocks[b->next].prev = b->prev;
+    else
+        cache->lru = b->prev;
+}
+
+/* Move a block to the most recently used end. */
+static void
+hdd_image_cache_touch(hdd_image_cache_t *cache, hdd_image_cache_block_t *b)
+{
+    int32_t i = (int32_t) (b - cache->blocks);
+
+    if (cache->mru == i)
+        return;
+
+    hdd_image_cache_unlink(cache, b);
+
+    b->prev = -1;
+    b->next = cache->mru;
+    if (cache->mru != -1)
+        cache->blocks[cache->mru].prev = i;
+    cache->mru = i;
+    if (cache->lru == -1)
+        cache->lru = i;
+}
+
+static void
+hdd_image_cache_unhash(hdd_image_cache_t *cache, hdd_image_cache_block_t *b)
+{
+    int32_t  i = (int32_t) (b - cache->blocks);
+    int32_t *p;
+
+    if (b->block == HDD_CACHE_FREE)
+        return;
+
+    for (p = &cache->hash[b->block & cache->hash_mask]; *p != -1; p = &cache->blocks[*p].hnext) {
+        if (*p == i) {
+            *p = b->hnext;
+            break;
+        }
+    }
+
+    b->block = HDD_CACHE_FREE;
+}
+
+static hdd_image_cache_t *
+hdd_image_cache_init(void)
+{
+    hdd_image_cache_t *cache;
+    uint32_t           num       = ((uint32_t) hdd_cache_size << 20) / (HDD_CACHE_BLOCK << 9);
+    uint32_t           hash_size = 1;
+
+    while (hash_size < (num << 1))
+        hash_size <<= 1;
+
+    cache = (hdd_image_cache_t *) calloc(1, sizeof(hdd_image_cache_t));
+    if (cache == NULL)
+        return NULL;
+
+    cache->blocks = (hdd_image_cache_block_t *) calloc(num, sizeof(hdd_image_cache_block_t));
+    cache->hash   = (int32_t *) malloc(hash_size * sizeof(int32_t));
+    cache->data   = (uint8_t *) malloc((size_t) num * (HDD_CACHE_BLOCK << 9));
+    if ((cache->blocks == NULL) || (cache->hash == NULL) || (cache->data == NULL)) {
+        free(cache->blocks);
+        free(cache->hash);
+        free(cache->data);
+        free(cache);
+        return NULL;
+    }
+
+    memset(cache->hash, 0xff, hash_size * sizeof(int32_t));
+    cache->hash_mask = hash_size - 1;
+    cache->num       = num;
+
+    /* Chain every block into the LRU list as free. */
+    for (uint32_t i = 0; i < num; i++) {
+        cache->blocks[i].block = HDD_CACHE_FREE;
+        cache->blocks[i].hnext = -1;
+        cache->blocks[i].prev  = (int32_t) i - 1;
+        cache->blocks[i].next  = ((i + 1) < num) ? (int32_t) (i + 1) : -1;
+        cache->blocks[i].data  = cache->data + ((size_t) i * (HDD_CACHE_BLOCK << 9));
+    }
+    cache->mru = 0;
+    cache->lru = (int32_t) num - 1;
+
+    cache->next_sector = HDD_CACHE_FREE;
+
+    return cache;
+}
+
+static void
+hdd_image_cache_close(uint8_t id)
+{
+    hdd_image_cache_t *cache = hdd_images[id].cache;
+
+    if (cache == NULL)
+        return;
+
+    pclog("Hard disk image %i: Cache %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " blocks read ahead\n",
+          id, cache->hits, cache->misses, cache->read_ahead);
+
+    free(cache->blocks);
+    free(cache->hash);
+    free(cache->data);
+    free(cache);
+
+    hdd_images[id].cache = NULL;
+}
+
+/* Read a block from the image into the least recently used slot. */
+static hdd_image_cache_block_t *
+hdd_image_cache_fill(uint8_t id, uint32_t block)
+{
+    hdd_image_cache_t       *cache = hdd_images[id].cache;
+    hdd_image_cache_block_t *b     = &cache->blocks[cache->lru];
+    uint32_t                 first = block << HDD_CACHE_BLOCK_SHIFT;
+    uint32_t                 count = HDD_CACHE_BLOCK;
+
+    if (first > hdd_images[id].last_sector)
+        return NULL;
+    if ((hdd_images[id].last_sector - first) < count)
+        count = hdd_images[id].last_sector - first + 1;
+
+    hdd_image_cache_unhash(cache, b);
+
+    if (hdd_image_do_read(id, first, count, b->data) < 0)
+        return NULL;
+
+    b->block                              = block;
+    b->hnext                              = cache->hash[block & cache->hash_mask];
+    cache->hash[block & cache->hash_mask] = (int32_t) (b - cache->blocks);
+    hdd_image_cache_touch(cache, b);
+
+    return b;
+}
+
+/* Bring cached copies of a range up to date after it was written. */
+static void
+hdd_image_cache_update(uint8_t id, uint32_t sector, uint32_t count, const uint8_t *buffer)
+{
+    hdd_image_cache_t       *cache = hdd_images[id].cache;
+    hdd_image_cache_block_t *b;
+    uint32_t                 off;
+    uint32_t                 n;
+
+    if (cache == NULL)
+        return;
+
+    while (count) {
+        off = sector & (HDD_CACHE_BLOCK - 1);
+        n   = HDD_CACHE_BLOCK - off;
+        if (n > count)
+            n = count;
+
+        b = hdd_image_cache_lookup(cache, sector >> HDD_CACHE_BLOCK_SHIFT);
+        if (b != NULL)
+            memcpy(b->data + (off << 9), buffer, n << 9);
+
+        sector += n;
+        count -= n;
+        buffer += (n << 9);
+    }
+}
+
+/* Drop cached copies of a range whose contents are no longer known. */
+static void
+hdd_image_cache_invalidate(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_cache_t       *cache = hdd_images[id].cache;
+    hdd_image_cache_block_t *b;
+    uint32_t                 last;
+
+    if ((cache == NULL) || !count)
+        return;
+
+    last = (sector + count - 1) >> HDD_CACHE_BLOCK_SHIFT;
+    for (uint32_t i = sector >> HDD_CACHE_BLOCK_SHIFT; i <= last; i++) {
+        b = hdd_image_cache_lookup(cache, i);
+        if (b != NULL)
+            hdd_image_cache_unhash(cache, b);
+    }
+}
+
+static int
+hdd_image_cache_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_cache_t       *cache      = hdd_images[id].cache;
+    hdd_image_cache_block_t *b;
+    int                      sequential = (sector == cache->next_sector);
+    uint32_t                 block;
+    uint32_t                 off;
+    uint32_t                 n;
+
+    cache->next_sector = sector + count;
+
+    while (count) {
+        block = sector >> HDD_CACHE_BLOCK_SHIFT;
+        off   = sector & (HDD_CACHE_BLOCK - 1);
+        n     = HDD_CACHE_BLOCK - off;
+        if (n > count)
+            n = count;
+
+        b = hdd_image_cache_lookup(cache, block);
+        if (b != NULL) {
+            cache->hits++;
+            hdd_image_cache_touch(cache, b);
+        } else {
+            cache->misses++;
+            b = hdd_image_cache_fill(id, block);
+            if (b == NULL)
+                return hdd_image_do_read(id, sector, count, buffer);
+
+            if (sequential && (cache->lru != (int32_t) (b - cache->blocks)) &&
+                (hdd_image_cache_lookup(cache, block + 1) == NULL) &&
+                (hdd_image_cache_fill(id, block + 1) != NULL)) {
+                cache->read_ahead++;
+                /* Keep the block being read ahead of the read-ahead one. */
+                hdd_image_cache_touch(cache, b);
+            }
+        }
+
+        memcpy(buffer, b->data + (off << 9), n << 9);
+
+        sector += n;
+        count -= n;
+        buffer += (n << 9);
+    }
+
+    hdd_images[id].pos = sector;
+
+    return 0;
+}
+
+void
+hdd_image_cache_stats(uint8_t id, uint64_t *hits, uint64_t *misses)
+{
+    const hdd_image_cache_t *cache = hdd_images[id].cache;
+
+    *hits   = cache ? cache->hits : 0;
+    *misses = cache ? cache->misses : 0;
+}
+
+int
+hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if ((hdd_images[id].cache == NULL) && (hdd_cache_size > 0))
+        hdd_images[id].cache = hdd_image_cache_init();
+
+    if (hdd_images[id].cache == NULL)
+        return hdd_image_do_read(id, sector, count, buffer);
+
+    return hdd_image_cache_read(id, sector, count, buffer);
+}
+
+int
+hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    int ret = hdd_image_do_write(id, sector, count, buffer);
+
+    if (ret < 0)
+        hdd_image_cache_invalidate(id, sector, count);
+    else
+        hdd_image_cache_update(id, sector, count, buffer);
+
+    return ret;
+}
+
 int
 hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
@@ -629,7 +1594,18 @@ hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 int
 hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
 {
-    if (hdd_images[id].type == HDD_IMAGE_VHD) {
+    static uint8_t zero_block[HDD_OVERLAY_BLOCK << 9];
+    uint32_t       n;
+
+    hdd_image_cache_invalidate(id, sector, count);
+
+    if (hdd_images[id].ovl_fp != NULL) {
+        for (; count; count -= n, sector += n) {
+            n = (count > HDD_OVERLAY_BLOCK) ? HDD_OVERLAY_BLOCK : count;
+            if (hdd_image_overlay_write(id, sector, n, zero_block) < 0)
+                return -1;
+        }
+    } else if (hdd_images[id].type == HDD_IMAGE_VHD) {
         hdd_images[id].vhd->error   = 0;
         int non_transferred_sectors = mvhd_format_sectors(hdd_images[id].vhd, sector, count);
         hdd_images[id].pos          = sector + count - non_transferred_sectors - 1;
@@ -638,7 +1614,13 @@ hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
     } else {
         memset(empty_sector, 0, 512);
 
+        /* Formatting is rare, just let any queued writes land first. */
+        if (hdd_image_drain(&hdd_images[id]) < 0)
+            return -1;
+        hdd_image_lock(&hdd_images[id]);
+
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
+            hdd_image_unlock(&hdd_images[id]);
             hdd_image_log("Hard disk image %i: Zero error during seek\n", id);
             return -1;
         }
@@ -648,11 +1630,15 @@ hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
                 break;
 
             hdd_images[id].pos = sector + i;
-            if (!fwrite(empty_sector, 512, 1, hdd_images[id].file))
+            if (!fwrite(empty_sector, 512, 1, hdd_images[id].file)) {
+                hdd_image_unlock(&hdd_images[id]);
                 return -1;
+            }
         }
 
-        fflush(hdd_images[id].file);
+        if (!hdd_write_back)
+            fflush(hdd_images[id].file);
+        hdd_image_unlock(&hdd_images[id]);
     }
 
     return 0;
@@ -693,6 +1679,9 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
         return;
 
     if (hdd_images[id].loaded) {
+        hdd_image_stop(&hdd_images[id]);
+        hdd_image_cache_close(id);
+        hdd_image_overlay_close(&hdd_images[id]);
         if (hdd_images[id].file != NULL) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
@@ -716,6 +1705,10 @@ hdd_image_close(uint8_t id)
     if (!hdd_images[id].loaded)
         return;
 
+    hdd_image_stop(&hdd_images[id]);
+    hdd_image_cache_close(id);
+    hdd_image_overlay_close(&hdd_images[id]);
+
     if (hdd_images[id].file != NULL) {
         fclose(hdd_images[id].file);
         hdd_images[id].file = NULL;
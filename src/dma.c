@@ -31,6 +31,8 @@
 #include <86box/io.h>
 #include <86box/pic.h>
 #include <86box/dma.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/plat_unused.h>
 
 dma_t   dma[8];
@@ -1114,6 +1116,24 @@ dma_set_at(uint8_t at)
     dma_at = at;
 }
 
+void
+dma_savestate(savestate_t *st)
+{
+    savestate_var(st, dma);
+    savestate_var(st, dma_e);
+    savestate_var(st, dma_m);
+    savestate_var(st, dmaregs);
+    savestate_var(st, dma_wp);
+    savestate_var(st, dma_stat);
+    savestate_var(st, dma_stat_rq);
+    savestate_var(st, dma_stat_rq_pc);
+    savestate_var(st, dma_stat_adv_pend);
+    savestate_var(st, dma_command);
+    savestate_var(st, dma_req_is_soft);
+    savestate_var(st, dma_sg_base);
+    savestate_var(st, dma_ps2);
+}
+
 void
 dma_reset(void)
 {
@@ -1864,50 +1884,77 @@ dma_mode(int channel)
 }
 
 /* DMA Bus Master Page Read/Write */
+/*
+ * Busmaster transfers are done one granule at a time: plain RAM is
+ * copied in one go, anything else goes through the mapping handlers
+ * in TransferSize units, same as a real busmaster would access it.
+ */
 void
 dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int TransferSize)
 {
-    uint32_t n;
-    uint32_t n2;
-    uint8_t  bytes[4] = { 0, 0, 0, 0 };
-
-    n  = TotalSize & ~(TransferSize - 1);
-    n2 = TotalSize - n;
-
-    /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_read_phys((void *) &(DataRead[i]), PhysAddress + i, TransferSize);
-    }
+    uint32_t       i = 0;
+    uint32_t       end;
+    uint32_t       len;
+    const uint8_t *p;
+    uint8_t        bytes[4] = { 0, 0, 0, 0 };
+
+    while (i < TotalSize) {
+        p = mem_get_phys_ptr(PhysAddress + i, &len, 0);
+        if (len > (TotalSize - i))
+            len = TotalSize - i;
+
+        if (p != NULL) {
+            memcpy(&(DataRead[i]), p, len);
+            i += len;
+            continue;
+        }
 
-    /* Do the non-divisible block, if there is one. */
-    if (n2) {
-        mem_read_phys((void *) bytes, PhysAddress + n, TransferSize);
-        memcpy((void *) &(DataRead[n]), bytes, n2);
+        for (end = i + len; i < end;) {
+            if ((TotalSize - i) >= (uint32_t) TransferSize) {
+                mem_read_phys((void *) &(DataRead[i]), PhysAddress + i, TransferSize);
+                i += TransferSize;
+            } else {
+                /* Do the non-divisible block. */
+                mem_read_phys((void *) bytes, PhysAddress + i, TransferSize);
+                memcpy((void *) &(DataRead[i]), bytes, TotalSize - i);
+                i = TotalSize;
+            }
+        }
     }
 }
 
 void
 dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize, int TransferSize)
 {
-    uint32_t n;
-    uint32_t n2;
+    uint32_t i = 0;
+    uint32_t end;
+    uint32_t len;
+    uint8_t *p;
     uint8_t  bytes[4] = { 0, 0, 0, 0 };
 
-    n  = TotalSize & ~(TransferSize - 1);
-    n2 = TotalSize - n;
+    while (i < TotalSize) {
+        p = mem_get_phys_ptr(PhysAddress + i, &len, 1);
+        if (len > (TotalSize - i))
+            len = TotalSize - i;
 
-    /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_write_phys((void *) &(DataWrite[i]), PhysAddress + i, TransferSize);
-    }
+        if (p != NULL) {
+            memcpy(p, &(DataWrite[i]), len);
+            i += len;
+            continue;
+        }
 
-    /* Do the non-divisible block, if there is one. */
-    if (n2) {
-        mem_read_phys((void *) bytes, PhysAddress + n, TransferSize);
-        memcpy(bytes, (void *) &(DataWrite[n]), n2);
-        mem_write_phys((void *) bytes, PhysAddress + n, TransferSize);
+        for (end = i + len; i < end;) {
+            if ((TotalSize - i) >= (uint32_t) TransferSize) {
+                mem_write_phys((void *) &(DataWrite[i]), PhysAddress + i, TransferSize);
+                i += TransferSize;
+            } else {
+                /* Do the non-divisible block. */
+                mem_read_phys((void *) bytes, PhysAddress + i, TransferSize);
+                memcpy(bytes, (void *) &(DataWrite[i]), TotalSize - i);
+                mem_write_phys((void *) bytes, PhysAddress + i, TransferSize);
+                i = TotalSize;
+            }
+        }
     }
 
     if (dma_at)
@@ -18,6 +18,7 @@
  *          Copyright 2025 Toni Riikonen.
  */
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,6 +40,7 @@
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
 #include <86box/fifo.h>
+#include <86box/savestate.h>
 
 extern uint64_t motoron[FDD_NUM];
 
@@ -2506,6 +2508,30 @@ fdc_reset(void *priv)
     fdc->media_id   = 0;
 }
 
+static void
+fdc_savestate(void *priv, savestate_t *st)
+{
+    fdc_t *fdc = (fdc_t *) priv;
+
+    if (st->saving && timer_is_enabled(&fdc->timer))
+        savestate_refuse(st, "fdc", "a command is in progress");
+
+    /* The I/O base, IRQ and DMA channel come from the machine and stay put. */
+    savestate_rw(st, fdc, offsetof(fdc_t, base_address));
+    savestate_var(st, fdc->rw_track);
+    savestate_rw(st, &fdc->bit_rate, offsetof(fdc_t, irq) - offsetof(fdc_t, bit_rate));
+    savestate_var(st, fdc->drvrate);
+    savestate_var(st, fdc->fifointest);
+    savestate_var(st, fdc->read_track_sector);
+    savestate_var(st, fdc->format_sector_id);
+    savestate_var(st, fdc->watchdog_count);
+    savestate_timer(st, &fdc->timer);
+    savestate_timer(st, &fdc->watchdog_timer);
+    savestate_fifo(st, fdc->fifo_p, 16);
+
+    fdd_savestate(st);
+}
+
 static void
 fdc_close(void *priv)
 {
@@ -2586,7 +2612,8 @@ const device_t fdc_xt_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = fdc_savestate
 };
 
 const device_t fdc_xt_sec_device = {
@@ -2712,7 +2739,8 @@ const device_t fdc_at_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = fdc_savestate
 };
 
 const device_t fdc_at_sec_device = {
@@ -2796,7 +2824,8 @@ const device_t fdc_at_smc_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = fdc_savestate
 };
 
 const device_t fdc_at_ali_device = {
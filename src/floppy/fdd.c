@@ -42,6 +42,7 @@
 #include <86box/fdd_td0.h>
 #include <86box/fdc.h>
 #include <86box/fdd_audio.h>
+#include <86box/savestate.h>
 
 /* Flags:
    Bit  0:  300 rpm supported;
@@ -713,6 +714,27 @@ fdd_set_motor_enable(int drive, int motor_enable)
     motoron[drive] = motor_enable;
 }
 
+void
+fdd_savestate(savestate_t *st)
+{
+    for (int i = 0; i < FDD_NUM; i++) {
+        if (st->saving && (motoron[i] || fdd_seek_in_progress[i]))
+            savestate_refuse(st, "fdd", "a drive motor is running");
+
+        savestate_var(st, fdd[i].track);
+        savestate_var(st, fdd[i].densel);
+        savestate_var(st, fdd[i].head);
+        savestate_var(st, fdd_changed[i]);
+    }
+
+    if (st->saving || st->error)
+        return;
+
+    /* Every motor was off when the state was saved. */
+    for (int i = 0; i < FDD_NUM; i++)
+        fdd_set_motor_enable(i, 0);
+}
+
 static void
 fdd_poll(void *priv)
 {
@@ -124,6 +124,8 @@ extern char vm_name[1024];  /* (O) display name of the VM */
 extern uint8_t  instru_enabled;
 extern uint64_t instru_run_ms;
 #endif
+extern int      batch_mode;   /* (O) run as fast as possible */
+extern uint64_t batch_run_ms; /* (O) batch mode: emulated ms to run */
 
 #define window_x monitor_settings[0].mon_window_x
 #define window_y monitor_settings[0].mon_window_y
@@ -147,6 +149,7 @@ extern int      vid_cga_comp_contrast;      /* (C) CGA composite saturation */
 extern int      video_fullscreen;           /* (C) video */
 extern int      video_fullscreen_scale;     /* (C) video */
 extern int      enable_overscan;            /* (C) video */
+extern int      vid_render_thread;          /* (C) render SVGA lines on a worker thread */
 extern int      force_43;                   /* (C) video */
 extern int      video_filter_method;        /* (C) video */
 extern int      video_vsync;                /* (C) video */
@@ -169,8 +172,11 @@ extern int      xga_standalone_enabled;     /* (C) video option */
 extern int      da2_standalone_enabled;     /* (C) video option */
 extern uint32_t mem_size;                   /* (C) memory size (Installed on system board) */
 extern uint32_t isa_mem_size;               /* (C) memory size (ISA Memory Cards) */
+extern char     mem_ram_image[1024];        /* (C) golden RAM image, mapped copy-on-write */
 extern int      cpu;                        /* (C) cpu type */
 extern int      cpu_use_dynarec;            /* (C) cpu uses/needs Dyna */
+extern int      dynarec_cache_size;         /* (C) dynarec code cache in MB, 0 = default */
+extern int      dynarec_compile_budget;     /* (C) dynarec uOPs compiled per slice, 0 = no limit */
 extern int      fpu_type;                   /* (C) fpu type */
 extern int      fpu_softfloat;              /* (C) fpu uses softfloat */
 extern int      time_sync;                  /* (C) enable time sync */
@@ -261,6 +267,7 @@ extern void pc_send_cad(void);
 extern void pc_send_cae(void);
 extern void pc_send_cab(void);
 extern void pc_run(void);
+extern int  pc_batch_frame(void);
 extern void pc_start(void);
 extern void pc_onesec(void);
 
@@ -155,6 +155,8 @@ typedef struct _device_config_ {
     const device_config_bios_t       bios[32];
 } device_config_t;
 
+struct savestate_t;
+
 typedef struct _device_ {
     const char *name;
     const char *internal_name;
@@ -172,6 +174,9 @@ typedef struct _device_ {
     void (*force_redraw)(void *priv);
 
     const device_config_t *config;
+
+    /* Read or write the device state, see savestate.h. */
+    void (*savestate)(void *priv, struct savestate_t *st);
 } device_t;
 
 typedef struct device_context_t {
@@ -208,6 +213,8 @@ extern void  device_speed_changed(void);
 extern void  device_force_redraw(void);
 extern void  device_get_name(const device_t *dev, int bus, char *name);
 extern int   device_has_config(const device_t *dev);
+extern const char *device_savestate_unsupported(void);
+extern void  device_savestate_all(struct savestate_t *st);
 
 extern uint8_t     device_get_bios_type(const device_t *dev, const char *internal_name);
 extern uint8_t     device_get_bios_num_files(const device_t *dev, const char *internal_name);
@@ -32,6 +32,8 @@ extern "C" {
 extern int fdd_swap;
 
 extern void fdd_set_motor_enable(int drive, int motor_enable);
+struct savestate_t;
+extern void fdd_savestate(struct savestate_t *st);
 extern void fdd_do_seek(int drive, int track);
 extern void fdd_forced_seek(int drive, int track_diff);
 extern void fdd_seek(int drive, int track_diff);
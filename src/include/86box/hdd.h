@@ -83,6 +83,12 @@ enum {
     HDD_OP_WRITE = 3
 };
 
+enum {
+    HDD_OVERLAY_NONE    = 0,
+    HDD_OVERLAY_COMMIT  = 1,
+    HDD_OVERLAY_DISCARD = 2
+};
+
 #define HDD_MAX_ZONES     16
 #define HDD_MAX_CACHE_SEG 16
 
@@ -164,6 +170,8 @@ typedef struct hard_disk_t {
     char               fn[1024];     /* Name of current image file */
     /* Differential VHD parent file */
     char               vhd_parent[1280];
+    /* Copy-on-write overlay file, the image itself is then read-only */
+    char               overlay[1024];
 
     uint32_t           seek_pos;
     uint32_t           seek_len;
@@ -200,6 +208,9 @@ typedef struct hard_disk_t {
 } hard_disk_t;
 
 extern hard_disk_t  hdd[HDD_NUM];
+extern int          hdd_write_back;
+extern int          hdd_cache_size; /* MB per image, 0 = disabled */
+extern int          hdd_overlay_action;
 extern unsigned int hdd_table[128][3];
 
 extern int   hdd_init(void);
@@ -221,6 +232,7 @@ extern uint32_t hdd_image_get_pos(uint8_t id);
 extern uint8_t  hdd_image_get_type(uint8_t id);
 extern void     hdd_image_unload(uint8_t id, int fn_preserve);
 extern void     hdd_image_close(uint8_t id);
+extern void     hdd_image_cache_stats(uint8_t id, uint64_t *hits, uint64_t *misses);
 extern void     hdd_image_calc_chs(uint32_t *c, uint32_t *h, uint32_t *s, uint32_t size);
 
 extern int image_is_hdi(const char *s);
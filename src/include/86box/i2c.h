@@ -15,6 +15,8 @@
 #ifndef EMU_I2C_H
 #define EMU_I2C_H
 
+struct savestate_t;
+
 /* i2c.c */
 extern void *i2c_smbus;
 
@@ -52,6 +54,7 @@ extern void    i2c_stop(void *bus_handle, uint8_t addr);
 /* i2c_eeprom.c */
 extern uint8_t log2i(uint32_t i);
 extern void   *i2c_eeprom_init(void *i2c, uint8_t addr, uint8_t *data, uint32_t size, uint8_t writable);
+extern void    i2c_eeprom_savestate(void *dev_handle, struct savestate_t *st);
 extern void    i2c_eeprom_close(void *dev_handle);
 
 /* i2c_gpio.c */
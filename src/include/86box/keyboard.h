@@ -19,6 +19,8 @@
 #ifndef EMU_KEYBOARD_H
 #define EMU_KEYBOARD_H
 
+struct savestate_t;
+
 #define FLAG_AT        0x00  /* dev is AT         */
 #define FLAG_PS2_KBD   0x10  /* dev is AT or PS/2 */
 #define FLAG_AX        0x08  /* dev is AX         */
@@ -241,6 +243,7 @@ extern uint8_t      kbc_at_dev_queue_pos(atkbc_dev_t *dev, uint8_t main);
 extern void         kbc_at_dev_queue_add(atkbc_dev_t *dev, uint8_t val, uint8_t main);
 extern void         kbc_at_dev_reset(atkbc_dev_t *dev, int do_fa);
 extern atkbc_dev_t *kbc_at_dev_init(uint8_t inst);
+extern void         kbc_at_dev_savestate(atkbc_dev_t *dev, struct savestate_t *st);
 /* This is so we can disambiguate scan codes that would otherwise conflict and get
    passed on incorrectly. */
 extern uint16_t     convert_scan_code(uint16_t scan_code);
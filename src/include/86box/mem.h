@@ -190,6 +190,13 @@ typedef struct _mem_mapping_ {
 
     uint32_t flags;
 
+    /* Maintained by mem.c: list order and place in the mapping index. */
+    uint32_t seq;
+    uint32_t idx_first;
+    uint32_t idx_last;
+    uint32_t idx_stamp;
+    uint8_t  idx_state;
+
     /* There is never a needed to pass a pointer to the mapping itself, it is much preferable to
        prepare a structure with the requires data (usually, the base address and mask) instead. */
     void *priv; /* backpointer to device */
@@ -261,11 +268,33 @@ extern uint8_t *rom;
 extern uint32_t biosmask;
 extern uint32_t biosaddr;
 
-extern int        readlookup[256];
+/* Soft TLB. */
+#define TLB_SIZE_MAX 4096
+
+#define TLB_GLOBAL   0x01 /* mapped by a global page, kept across CR3 writes */
+#define TLB_CHANCE   0x02 /* not yet passed over by the replacement clock */
+
+typedef struct tlb_stats_t {
+    uint64_t read_fills;
+    uint64_t write_fills;
+    uint64_t evictions;
+    uint64_t flush_full;
+    uint64_t flush_nopc;
+    uint64_t flush_write;
+    uint64_t flush_cr3;
+    uint64_t global_kept; /* entries that survived a CR3 write */
+} tlb_stats_t;
+
+extern tlb_stats_t tlb_stats;
+extern int         cachesize;
+
+extern int        readlookup[TLB_SIZE_MAX];
+extern uint8_t    readlookup_flags[TLB_SIZE_MAX];
 extern uintptr_t  old_rl2;
 extern uint8_t    uncached;
 extern int        readlnext;
-extern int        writelookup[256];
+extern int        writelookup[TLB_SIZE_MAX];
+extern uint8_t    writelookup_flags[TLB_SIZE_MAX];
 
 extern int        writelnext;
 extern uint32_t   ram_mapped_addr[64];
@@ -301,6 +330,7 @@ extern int memspeed[11];
 extern uint8_t high_page; /* if a high (> 4 gb) page was detected */
 
 extern uint8_t *_mem_exec[MEM_MAPPINGS_NO];
+extern uint32_t mem_exec_gen;
 
 extern uint32_t pages_sz; /* #pages in table */
 extern int      read_type;
@@ -332,6 +362,12 @@ extern void     writememll_no_mmut(uint32_t addr, uint32_t *a64, uint32_t val);
 
 extern void do_mmutranslate(uint32_t addr, uint32_t *a64, int num, int write);
 
+extern uint32_t fetch_2386_page;
+extern uint32_t fetch_2386_gen;
+extern uint8_t *fetch_2386_base;
+extern uint8_t  fetch_2386_user;
+extern uint8_t *fetch_2386_fill(uint32_t addr);
+
 extern uint8_t  readmembl_2386(uint32_t addr);
 extern void     writemembl_2386(uint32_t addr, uint8_t val);
 extern uint16_t readmemwl_2386(uint32_t addr);
@@ -416,6 +452,7 @@ extern void     mem_writeb_phys(uint32_t addr, uint8_t val);
 extern void     mem_writew_phys(uint32_t addr, uint16_t val);
 extern void     mem_writel_phys(uint32_t addr, uint32_t val);
 extern void     mem_write_phys(void *src, uint32_t addr, int tranfer_size);
+extern uint8_t *mem_get_phys_ptr(uint32_t addr, uint32_t *len, int write);
 
 extern uint8_t  mem_read_ram(uint32_t addr, void *priv);
 extern uint16_t mem_read_ramw(uint32_t addr, void *priv);
@@ -445,6 +482,7 @@ extern void mem_flush_write_page(uint32_t addr, uint32_t virt);
 extern void mem_reset_page_blocks(void);
 
 extern void flushmmucache(void);
+extern void flushmmucache_cr3(void);
 extern void flushmmucache_write(void);
 extern void flushmmucache_pc(void);
 extern void flushmmucache_nopc(void);
@@ -457,6 +495,7 @@ extern void mem_a20_recalc(void);
 extern void mem_init(void);
 extern void mem_close(void);
 extern void mem_zero(void);
+extern void mem_ram_image_stats(void);
 extern void mem_reset(void);
 extern void mem_remap_top_ex(int kb, uint32_t start);
 extern void mem_remap_top_ex_nomid(int kb, uint32_t start);
@@ -0,0 +1,71 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the sampling host profiler.
+ *
+ *
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#ifndef EMU_PROFILER_H
+#define EMU_PROFILER_H
+
+/* What the emulation thread is doing, as seen by the sampler. */
+enum {
+    PROF_IDLE = 0, /* waiting for the host clock, or paused */
+    PROF_OTHER,    /* rest of pc_run(): input, blitter hand-off */
+    PROF_INTERP,   /* CPU interpreter, including block compilation */
+    PROF_JIT,      /* code generated by the dynamic recompiler */
+    PROF_MEM,      /* memory accesses that missed the soft TLB */
+    PROF_IO,       /* port I/O */
+    PROF_TIMER,    /* timer_process() bookkeeping */
+    PROF_DEVICE,   /* timer callbacks of devices */
+    PROF_RENDER,   /* SVGA scanline rendering done by svga_poll() */
+    PROF_MAX
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Written by the emulation thread, read by the sampler thread. */
+extern volatile int prof_cat;
+extern int          prof_running;
+
+/* (O) Command line: profile from start-up, write the report to this file. */
+extern char prof_report_path[1024];
+
+extern void prof_start(void);
+extern void prof_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Switching category is a single store, cheap enough to be done whether
+ * or not the sampler is running. Categories nest, the caller keeps the
+ * previous one and hands it back to prof_leave().
+ */
+static __inline int
+prof_enter(int cat)
+{
+    int old = prof_cat;
+
+    prof_cat = cat;
+
+    return old;
+}
+
+static __inline void
+prof_leave(int old)
+{
+    prof_cat = old;
+}
+
+#endif /*EMU_PROFILER_H*/
@@ -0,0 +1,65 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the whole-machine save state module.
+ *
+ *
+ *
+ *          Copyright 2025 The 86Box development team
+ */
+#ifndef EMU_SAVESTATE_H
+#define EMU_SAVESTATE_H
+
+/* Bump this whenever the layout of any section changes. */
+#define SAVESTATE_VERSION 2
+
+#define SAVESTATE_NAME_LEN 64
+
+typedef struct savestate_t {
+    FILE *fp;
+    int   saving; /* 1 = writing the state out, 0 = reading it back in */
+    int   error;  /* set on the first short read/write or section mismatch */
+} savestate_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* (O) Command line: restore from this file at start-up. */
+extern char savestate_load_path[1024];
+/* (O) Command line: save to this file on exit. */
+extern char savestate_save_path[1024];
+
+/* Read or write a block of raw data, depending on the direction. */
+extern void savestate_rw(savestate_t *st, void *data, size_t size);
+/* Write, or read and verify, a section tag. */
+extern void savestate_section(savestate_t *st, const char *tag);
+/* Read or write a timer, re-arming it on load if it was enabled. */
+extern void savestate_timer(savestate_t *st, pc_timer_t *timer);
+/* Read or write the contents of a fifo_init() FIFO of the given size. */
+extern void savestate_fifo(savestate_t *st, void *fifo, int size);
+/* Fail a save because the device is in a state that can not be stored. */
+extern void savestate_refuse(savestate_t *st, const char *dev, const char *reason);
+
+#define savestate_var(st, var) savestate_rw((st), &(var), sizeof(var))
+
+extern int savestate_save(const char *fn);
+extern int savestate_load(const char *fn);
+
+/* Core (non-device) modules. */
+extern void cpu_savestate(savestate_t *st);
+extern void mem_savestate(savestate_t *st);
+extern void pic_savestate(savestate_t *st);
+extern void dma_savestate(savestate_t *st);
+extern void pci_savestate(savestate_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SAVESTATE_H*/
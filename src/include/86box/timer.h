@@ -50,8 +50,7 @@ typedef struct pc_timer_t {
     void (*callback)(void *priv);
     void *priv;
 
-    struct pc_timer_t *prev;
-    struct pc_timer_t *next;
+    uint32_t heap_pos; /* Position in the timer heap plus one, 0 if not queued. */
 } pc_timer_t;
 
 #ifdef __cplusplus
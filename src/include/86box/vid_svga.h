@@ -31,6 +31,7 @@
 #    define FLAG_PRECISETIME  2048 /* Needed for Copper demo if on dynarec. */
 #    define FLAG_PANNING_ATI  4096
 struct monitor_t;
+struct savestate_t;
 
 typedef struct hwcursor_t {
     int      ena;
@@ -331,6 +332,12 @@ typedef struct svga_t {
     void *     priv_parent;
 
     void *     local;
+
+    /* Bumped by the palette, attribute, character set and DAC mask writes
+       and by svga_recalctimings(), i.e. when the renderers' inputs change. */
+    uint32_t   render_gen;
+    /* Line render worker, NULL if lines are rendered in svga_poll() itself. */
+    void *     render_thread;
 } svga_t;
 
 extern void     ibm8514_set_poll(svga_t *svga);
@@ -374,6 +381,7 @@ extern int  svga_init(const device_t *info, svga_t *svga, void *priv, int memsiz
                       void (*overlay_draw)(struct svga_t *svga, int displine));
 extern void svga_recalctimings(svga_t *svga);
 extern void svga_close(svga_t *svga);
+extern void svga_savestate(svga_t *svga, struct savestate_t *st);
 
 uint8_t  svga_read(uint32_t addr, void *priv);
 uint16_t svga_readw(uint32_t addr, void *priv);
@@ -416,6 +424,7 @@ enum {
 };
 
 uint32_t svga_lookup_lut_ram(svga_t* svga, uint32_t val);
+uint32_t svga_conv_16to32(struct svga_t *svga, uint16_t color, uint8_t bpp);
 
 /* We need a way to add a device with a pointer to a parent device so it can attach itself to it, and
    possibly also a second ATi 68860 RAM DAC type that auto-sets SVGA render on RAM DAC render change. */
@@ -34,6 +34,7 @@ extern uint8_t edatlookup[4][4];
 extern uint8_t egaremap2bpp[256];
 
 extern void svga_recalc_remap_func(svga_t *svga);
+extern void svga_render_check_sse2(void);
 
 extern void svga_render_null(svga_t *svga);
 extern void svga_render_blank(svga_t *svga);
@@ -26,8 +26,10 @@
 #define LOD_MAX         8
 
 #define TEX_DIRTY_SHIFT 10
+#define TEX_DIRTY_PAGES (16 << (20 - TEX_DIRTY_SHIFT))
 
-#define TEX_CACHE_MAX   64
+#define TEX_CACHE_MIN   64
+#define TEX_CACHE_MAX   256
 
 #ifdef __cplusplus
 #    include <atomic>
@@ -101,6 +103,12 @@ enum {
 #define PARAM_FULL(x)    ((voodoo->params_write_idx - voodoo->params_read_idx[x]) >= PARAM_SIZE)
 #define PARAM_EMPTY(x)   (voodoo->params_read_idx[x] == voodoo->params_write_idx)
 
+#define VOODOO_MAX_RENDER_THREADS 16
+/*Scanlines are handed out to the render threads through a table of this many
+  entries, indexed by the line number modulo its size.*/
+#define VOODOO_RENDER_LINES       2048
+#define VOODOO_RENDER_LINE_MASK   (VOODOO_RENDER_LINES - 1)
+
 typedef struct
 {
     uint32_t addr_type;
@@ -231,11 +239,12 @@ typedef struct texture_t {
     uint32_t   base;
     uint32_t   tLOD;
     atomic_int refcount;
-    atomic_int refcount_r[4];
+    atomic_int refcount_r[VOODOO_MAX_RENDER_THREADS];
     int        is16;
     uint32_t   palette_checksum;
     uint32_t   addr_start[4];
     uint32_t   addr_end[4];
+    int        hash_next;
     uint32_t  *data;
 } texture_t;
 
@@ -263,6 +272,12 @@ typedef struct clip_t {
     int y_max;
 } clip_t;
 
+/*Argument of a render thread.*/
+typedef struct voodoo_render_param_t {
+    struct voodoo_t *voodoo;
+    int              index;
+} voodoo_render_param_t;
+
 typedef struct voodoo_t {
     mem_mapping_t mapping;
 
@@ -359,25 +374,31 @@ typedef struct voodoo_t {
     int    ncc_dirty[2];
 
     thread_t *fifo_thread;
-    thread_t *render_thread[4];
+    thread_t *render_thread[VOODOO_MAX_RENDER_THREADS];
     event_t  *wake_fifo_thread;
     event_t  *wake_main_thread;
     event_t  *fifo_not_full_event;
-    event_t  *render_not_full_event[4];
-    event_t  *wake_render_thread[4];
+    event_t  *render_not_full_event[VOODOO_MAX_RENDER_THREADS];
+    event_t  *wake_render_thread[VOODOO_MAX_RENDER_THREADS];
 
     int voodoo_busy;
-    int render_voodoo_busy[4];
+    int render_voodoo_busy[VOODOO_MAX_RENDER_THREADS];
 
     int render_threads;
-    int odd_even_mask;
 
-    int pixel_count[4];
-    int texel_count[4];
+    /*Render thread that draws each scanline, and the pixels it drew on the
+      line since the last rebalance.*/
+    uint8_t  render_line_thread[VOODOO_RENDER_LINES];
+    uint32_t render_line_pixels[VOODOO_RENDER_LINES];
+
+    voodoo_render_param_t render_param[VOODOO_MAX_RENDER_THREADS];
+
+    int pixel_count[VOODOO_MAX_RENDER_THREADS];
+    int texel_count[VOODOO_MAX_RENDER_THREADS];
     int tri_count;
     int frame_count;
-    int pixel_count_old[4];
-    int texel_count_old[4];
+    int pixel_count_old[VOODOO_MAX_RENDER_THREADS];
+    int texel_count_old[VOODOO_MAX_RENDER_THREADS];
     int wr_count;
     int rd_count;
     int tex_count;
@@ -408,7 +429,7 @@ typedef struct voodoo_t {
     atomic_int   cmd_written_fifo_2;
 
     voodoo_params_t params_buffer[PARAM_SIZE];
-    atomic_int      params_read_idx[4];
+    atomic_int      params_read_idx[VOODOO_MAX_RENDER_THREADS];
     atomic_int      params_write_idx;
 
     uint32_t   cmdfifo_base;
@@ -655,15 +676,25 @@ typedef struct voodoo_t {
     uint8_t  thefilterb[256][256];
     uint16_t purpleline[256][3];
 
-    texture_t texture_cache[2][TEX_CACHE_MAX];
-    uint8_t   texture_present[2][16384];
-    int       texture_last_removed;
+    texture_t *texture_cache[2];
+    int        texture_cache_size;
+    int       *texture_hash[2];
+    uint32_t   texture_hash_mask;
+    uint64_t  *texture_pages[2];
+    int        texture_page_words;
+    uint8_t    texture_present[2][TEX_DIRTY_PAGES];
+    int        texture_last_removed;
+
+    uint64_t texture_hits;
+    uint64_t texture_misses;
+    uint64_t texture_stalls;
+    uint64_t texture_stall_ms;
 
     uint32_t palette_checksum[2];
     int      palette_dirty[2];
 
     uint64_t time;
-    int      render_time[4];
+    int      render_time[VOODOO_MAX_RENDER_THREADS];
 
     int      force_blit_count;
     int      can_blit;
@@ -675,7 +706,7 @@ typedef struct voodoo_t {
     struct voodoo_set_t *set;
 
     uint8_t fifo_thread_run;
-    uint8_t render_thread_run[4];
+    uint8_t render_thread_run[VOODOO_MAX_RENDER_THREADS];
 
     uint8_t *vram;
     uint8_t *changedvram;
@@ -24,6 +24,7 @@
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/io.h>
+#include <86box/profiler.h>
 #include <86box/timer.h>
 #include "cpu.h"
 #include "x86.h"
@@ -54,9 +55,18 @@ typedef struct {
     void     *priv;
 } io_trap_t;
 
-int   initialized = 0;
-io_t *io[NPORTS];
-io_t *io_last[NPORTS];
+/* Accesses that can skip the handler list walk, see io_fast_update(). */
+#define IO_FAST_INB  0x01
+#define IO_FAST_INW  0x02
+#define IO_FAST_INL  0x04
+#define IO_FAST_OUTB 0x10
+#define IO_FAST_OUTW 0x20
+#define IO_FAST_OUTL 0x40
+
+int     initialized = 0;
+io_t   *io[NPORTS];
+io_t   *io_last[NPORTS];
+uint8_t io_fast[NPORTS];
 
 #ifdef ENABLE_IO_LOG
 int io_do_log = ENABLE_IO_LOG;
@@ -105,6 +115,73 @@ io_init(void)
         /* io[c] should be NULL. */
         io[c] = io_last[c] = NULL;
     }
+
+    memset(io_fast, 0x00, sizeof(io_fast));
+}
+
+/* Nonzero if a width byte access at port - offset would also reach a
+   narrower handler on this port, same as the fallbacks in inw() to outl(). */
+static int
+io_port_splits(uint16_t port, int width, int offset, int write)
+{
+    int b;
+    int w;
+    int l;
+
+    for (const io_t *p = io[port]; p != NULL; p = p->next) {
+        b = write ? (p->outb != NULL) : (p->inb != NULL);
+        w = write ? (p->outw != NULL) : (p->inw != NULL);
+        l = write ? (p->outl != NULL) : (p->inl != NULL);
+
+        if (b && !w && ((width == 2) || !l))
+            return 1;
+        if ((width == 4) && !(offset & 1) && w && !l)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Work out which accesses to a port reduce to a single call of the only
+ * handler on it: those need no list walk and no merging of partial
+ * results. Wide accesses also depend on the ports they overlap, as any
+ * narrower handler there would get its part of the access as well.
+ */
+static void
+io_fast_update(uint16_t port)
+{
+    const io_t *p     = io[port];
+    uint8_t     flags = 0x00;
+
+    if ((p != NULL) && (p->next == NULL)) {
+        if (p->inb)
+            flags |= IO_FAST_INB;
+        if (p->inw && !io_port_splits(port + 1, 2, 1, 0))
+            flags |= IO_FAST_INW;
+        if (p->inl && !io_port_splits(port + 1, 4, 1, 0) && !io_port_splits(port + 2, 4, 2, 0) &&
+            !io_port_splits(port + 3, 4, 3, 0))
+            flags |= IO_FAST_INL;
+
+        if (p->outb)
+            flags |= IO_FAST_OUTB;
+        if (p->outw && !io_port_splits(port + 1, 2, 1, 1))
+            flags |= IO_FAST_OUTW;
+        if (p->outl && !io_port_splits(port + 1, 4, 1, 1) && !io_port_splits(port + 2, 4, 2, 1) &&
+            !io_port_splits(port + 3, 4, 3, 1))
+            flags |= IO_FAST_OUTL;
+    }
+
+    io_fast[port] = flags;
+}
+
+/* Rebuild the fast dispatch flags of every port an access could reach
+   the given range from. */
+static void
+io_fast_recalc(uint16_t base, int size)
+{
+    for (int c = -3; c < size; c++)
+        io_fast_update((uint16_t) (base + c));
 }
 
 void
@@ -147,6 +224,8 @@ io_sethandler_common(uint16_t base, int size,
 
         q = NULL;
     }
+
+    io_fast_recalc(base, size);
 }
 
 void
@@ -184,6 +263,8 @@ io_removehandler_common(uint16_t base, int size,
             p = q;
         }
     }
+
+    io_fast_recalc(base, size);
 }
 
 void
@@ -342,6 +423,7 @@ inb(uint16_t port)
 #ifdef ENABLE_IO_LOG
     int     qfound = 0;
 #endif
+    int     prof_old = prof_enter(PROF_IO);
 
     io_port = port;
 
@@ -360,6 +442,13 @@ inb(uint16_t port)
         found = 1;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_fast[port] & IO_FAST_INB) {
+        p     = io[port];
+        ret   = p->inb(port, p->priv);
+        found = 1;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -396,6 +485,8 @@ inb(uint16_t port)
 
     io_log("[%04X:%08X] (%i, %i, %04i) in b(%04X) = %02X\n", CS, cpu_state.pc, in_smm, found, qfound, port, ret);
 
+    prof_leave(prof_old);
+
     return ret;
 }
 
@@ -408,6 +499,7 @@ outb(uint16_t port, uint8_t val)
 #ifdef ENABLE_IO_LOG
     int   qfound = 0;
 #endif
+    int   prof_old = prof_enter(PROF_IO);
 
     io_port = port;
     io_val  = val;
@@ -427,6 +519,13 @@ outb(uint16_t port, uint8_t val)
         found = 1;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_fast[port] & IO_FAST_OUTB) {
+        p = io[port];
+        p->outb(port, val, p->priv);
+        found = 1;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -453,6 +552,8 @@ outb(uint16_t port, uint8_t val)
 
     io_log("[%04X:%08X] (%i, %i, %04i) outb(%04X, %02X)\n", CS, cpu_state.pc, in_smm, found, qfound, port, val);
 
+    prof_leave(prof_old);
+
     return;
 }
 
@@ -467,6 +568,7 @@ inw(uint16_t port)
     int      qfound = 0;
 #endif
     uint8_t  ret8[2];
+    int      prof_old = prof_enter(PROF_IO);
 
     io_port = port;
 
@@ -485,6 +587,13 @@ inw(uint16_t port)
         found = 2;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_fast[port] & IO_FAST_INW) {
+        p     = io[port];
+        ret   = p->inw(port, p->priv);
+        found = 2;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -533,6 +642,8 @@ inw(uint16_t port)
 
     io_log("[%04X:%08X] (%i, %i, %04i) in w(%04X) = %04X\n", CS, cpu_state.pc, in_smm, found, qfound, port, ret);
 
+    prof_leave(prof_old);
+
     return ret;
 }
 
@@ -545,6 +656,7 @@ outw(uint16_t port, uint16_t val)
 #ifdef ENABLE_IO_LOG
     int   qfound = 0;
 #endif
+    int   prof_old = prof_enter(PROF_IO);
 
     io_port = port;
     io_val  = val;
@@ -564,6 +676,13 @@ outw(uint16_t port, uint16_t val)
         found = 2;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_fast[port] & IO_FAST_OUTW) {
+        p = io[port];
+        p->outw(port, val, p->priv);
+        found = 2;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -605,6 +724,8 @@ outw(uint16_t port, uint16_t val)
 
     io_log("[%04X:%08X] (%i, %i, %04i) outw(%04X, %04X)\n", CS, cpu_state.pc, in_smm, found, qfound, port, val);
 
+    prof_leave(prof_old);
+
     return;
 }
 
@@ -620,6 +741,7 @@ inl(uint16_t port)
 #ifdef ENABLE_IO_LOG
     int      qfound = 0;
 #endif
+    int      prof_old = prof_enter(PROF_IO);
 
     io_port = port;
 
@@ -638,6 +760,13 @@ inl(uint16_t port)
         found = 4;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_fast[port] & IO_FAST_INL) {
+        p     = io[port];
+        ret   = p->inl(port, p->priv);
+        found = 4;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -717,6 +846,8 @@ inl(uint16_t port)
 
     io_log("[%04X:%08X] (%i, %i, %04i) in l(%04X) = %08X\n", CS, cpu_state.pc, in_smm, found, qfound, port, ret);
 
+    prof_leave(prof_old);
+
     return ret;
 }
 
@@ -730,6 +861,7 @@ outl(uint16_t port, uint32_t val)
     int   qfound = 0;
 #endif
     int   i      = 0;
+    int   prof_old = prof_enter(PROF_IO);
 
     io_port = port;
     io_val  = val;
@@ -749,6 +881,13 @@ outl(uint16_t port, uint32_t val)
         found = 4;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_fast[port] & IO_FAST_OUTL) {
+        p = io[port];
+        p->outl(port, val, p->priv);
+        found = 4;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -807,6 +946,8 @@ outl(uint16_t port, uint32_t val)
 
     io_log("[%04X:%08X] (%i, %i, %04i) outl(%04X, %08X)\n", CS, cpu_state.pc, in_smm, found, qfound, port, val);
 
+    prof_leave(prof_old);
+
     return;
 }
 
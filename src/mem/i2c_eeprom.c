@@ -22,6 +22,8 @@
 #include <86box/86box.h>
 #include <86box/i2c.h>
 #include <86box/plat_unused.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 
 typedef struct i2c_eeprom_t {
     void   *i2c;
@@ -33,6 +35,7 @@ typedef struct i2c_eeprom_t {
     uint32_t addr_register;
     uint8_t  addr_len;
     uint8_t  addr_pos;
+    uint32_t data_size;
 } i2c_eeprom_t;
 
 #ifdef ENABLE_I2C_EEPROM_LOG
@@ -128,6 +131,8 @@ i2c_eeprom_init(void *i2c, uint8_t addr, uint8_t *data, uint32_t size, uint8_t w
 {
     i2c_eeprom_t *dev = (i2c_eeprom_t *) calloc(1, sizeof(i2c_eeprom_t));
 
+    dev->data_size = size;
+
     /* Round size up to the next power of 2. */
     uint32_t pow_size = 1 << log2i(size);
     if (pow_size < size)
@@ -151,6 +156,18 @@ i2c_eeprom_init(void *i2c, uint8_t addr, uint8_t *data, uint32_t size, uint8_t w
     return dev;
 }
 
+void
+i2c_eeprom_savestate(void *dev_handle, savestate_t *st)
+{
+    i2c_eeprom_t *dev = (i2c_eeprom_t *) dev_handle;
+
+    /* The contents belong to the owner, except for what the guest wrote. */
+    if (dev->writable)
+        savestate_rw(st, dev->data, dev->data_size);
+    savestate_var(st, dev->addr_register);
+    savestate_var(st, dev->addr_pos);
+}
+
 void
 i2c_eeprom_close(void *dev_handle)
 {
@@ -15,6 +15,7 @@
  *          Copyright 2008-2020 Sarah Walker.
  *          Copyright 2016-2020 Miran Grca.
  */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -27,6 +28,7 @@
 #include <86box/timer.h>
 #include <86box/nvr.h>
 #include <86box/plat.h>
+#include <86box/savestate.h>
 
 #define FLAG_WORD    4
 #define FLAG_BXB     2
@@ -527,6 +529,17 @@ intel_flash_init(const device_t *info)
     return dev;
 }
 
+static void
+intel_flash_savestate(void *priv, savestate_t *st)
+{
+    flash_t *dev = (flash_t *) priv;
+
+    /* The mappings never change, the BIOS may have rewritten the array. */
+    savestate_rw(st, dev, offsetof(flash_t, array));
+    savestate_var(st, dev->program_addr);
+    savestate_rw(st, dev->array, biosmask + 1);
+}
+
 static void
 intel_flash_close(void *priv)
 {
@@ -564,7 +577,8 @@ const device_t intel_flash_bxt_ami_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = intel_flash_savestate
 };
 
 const device_t intel_flash_bxt_device = {
@@ -578,7 +592,8 @@ const device_t intel_flash_bxt_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = intel_flash_savestate
 };
 
 const device_t intel_flash_bxb_device = {
@@ -592,5 +607,6 @@ const device_t intel_flash_bxb_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = intel_flash_savestate
 };
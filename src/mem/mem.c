@@ -35,8 +35,11 @@
 #include <86box/config.h>
 #include <86box/io.h>
 #include <86box/mem.h>
+#include <86box/profiler.h>
 #include <86box/plat.h>
 #include <86box/rom.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/gdbstub.h>
 #ifdef USE_DYNAREC
 #    include "codegen_public.h"
@@ -82,12 +85,27 @@ uint32_t biosaddr;
 uint32_t pccache;
 uint8_t *pccache2;
 
+/*
+ * The soft TLB: readlookup[]/writelookup[] hold the virtual pages
+ * currently cached in readlookup2[]/writelookup2[] (or page_lookup[]),
+ * cachesize of them, replaced in a clock order in which pages mapped
+ * global get a second chance. Global pages survive CR3 writes when
+ * CR4.PGE is set.
+ */
 int        readlnext;
-int        readlookup[256];
+int        readlookup[TLB_SIZE_MAX];
+uint8_t    readlookup_flags[TLB_SIZE_MAX];
 uintptr_t  old_rl2;
 uint8_t    uncached = 0;
 int        writelnext;
-int        writelookup[256];
+int        writelookup[TLB_SIZE_MAX];
+uint8_t    writelookup_flags[TLB_SIZE_MAX];
+
+tlb_stats_t tlb_stats;
+
+/* Page of the last successful translation, and whether it was global. */
+static uint32_t mmu_last_page   = 0xffffffff;
+static int      mmu_last_global = 0;
 
 /* The lookup tables. */
 page_t *page_lookup[1048576] = { 0 };
@@ -101,7 +119,7 @@ int shadowbios = 0;
 int shadowbios_write;
 int readlnum  = 0;
 int writelnum = 0;
-int cachesize = 256;
+int cachesize = 256; /* (C) soft TLB entries, a power of two up to TLB_SIZE_MAX */
 
 uint32_t get_phys_virt;
 uint32_t get_phys_phys;
@@ -112,6 +130,10 @@ int mem_a20_state = 0;
 
 int mmuflush = 0;
 
+/* Bumped whenever _mem_exec[], the A20 mask or the MMU caches may have
+   changed, so that cached code page pointers can be revalidated cheaply. */
+uint32_t mem_exec_gen = 0;
+
 #ifdef USE_NEW_DYNAREC
 uint64_t *byte_dirty_mask;
 uint64_t *byte_code_present_mask;
@@ -138,6 +160,37 @@ static mem_state_t    _mem_state[MEM_MAPPINGS_NO];
 static uint32_t       remap_start_addr;
 static uint32_t       remap_start_addr2;
 static size_t ram_size = 0;
+static int    ram_is_image = 0;
+
+/*
+ * The mapping index: every mapping in the list is also filed into the
+ * 64 KB buckets its range covers, so that a recalc of a small range
+ * only has to look at the mappings that can overlap it. Mappings that
+ * are large or alias across the address space (base_ignore) go to the
+ * wide list, which is always visited. Within a bucket, mappings are
+ * kept in list order, since later mappings take precedence.
+ */
+#define MEM_INDEX_BITS       16
+#define MEM_INDEX_SIZE       (1 << (32 - MEM_INDEX_BITS))
+#define MEM_INDEX_SPAN_MAX   16 /* buckets, beyond that a mapping is wide */
+#define MEM_INDEX_RECALC_MAX 64 /* buckets, beyond that recalc walks the list */
+
+#define MEM_INDEX_NONE       0
+#define MEM_INDEX_BUCKETS    1
+#define MEM_INDEX_WIDE       2
+
+typedef struct mem_index_t {
+    mem_mapping_t **maps;
+    int             num;
+    int             max;
+} mem_index_t;
+
+static mem_index_t mem_index[MEM_INDEX_SIZE];
+static mem_index_t mem_index_wide;
+static mem_index_t mem_index_cand;
+static uint32_t    mem_mapping_seq = 0;
+static uint32_t    mem_seq_base    = 0;
+static uint32_t    mem_index_stamp = 0;
 
 #ifdef ENABLE_MEM_LOG
 int mem_do_log = ENABLE_MEM_LOG;
@@ -173,10 +226,12 @@ resetreadlookup(void)
     memset(page_lookup, 0x00, (1 << 20) * sizeof(page_t *));
 
     /* Initialize the tables for lower (<= 1024K) RAM. */
-    for (uint16_t c = 0; c < 256; c++) {
+    for (int c = 0; c < TLB_SIZE_MAX; c++) {
         readlookup[c]  = 0xffffffff;
         writelookup[c] = 0xffffffff;
     }
+    memset(readlookup_flags, 0x00, sizeof(readlookup_flags));
+    memset(writelookup_flags, 0x00, sizeof(writelookup_flags));
 
     /* Initialize the tables for high (> 1024K) RAM. */
     memset(readlookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
@@ -187,23 +242,68 @@ resetreadlookup(void)
     writelnext = 0;
     pccache    = 0xffffffff;
     high_page  = 0;
+
+    mmu_last_page   = 0xffffffff;
+    mmu_last_global = 0;
+
+    mem_log("TLB: %" PRIu64 " read fills, %" PRIu64 " write fills, %" PRIu64 " evictions, "
+            "%" PRIu64 " full flushes, %" PRIu64 " CR3 flushes (%" PRIu64 " global entries kept)\n",
+            tlb_stats.read_fills, tlb_stats.write_fills, tlb_stats.evictions,
+            tlb_stats.flush_full, tlb_stats.flush_cr3, tlb_stats.global_kept);
+    memset(&tlb_stats, 0x00, sizeof(tlb_stats_t));
 }
 
-void
-flushmmucache(void)
+/* Drop every soft TLB entry, or only the non-global ones. */
+static void
+mem_tlb_flush(int keep_global)
 {
-    for (uint16_t c = 0; c < 256; c++) {
+    for (int c = 0; c < cachesize; c++) {
         if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookup[c]              = 0xffffffff;
+            if (keep_global && (readlookup_flags[c] & TLB_GLOBAL))
+                tlb_stats.global_kept++;
+            else {
+                readlookup2[readlookup[c]] = LOOKUP_INV;
+                readlookup[c]              = 0xffffffff;
+                readlookup_flags[c]        = 0;
+            }
         }
         if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
+            if (keep_global && (writelookup_flags[c] & TLB_GLOBAL))
+                tlb_stats.global_kept++;
+            else {
+                page_lookup[writelookup[c]]  = NULL;
+                writelookup2[writelookup[c]] = LOOKUP_INV;
+                writelookup[c]               = 0xffffffff;
+                writelookup_flags[c]         = 0;
+            }
         }
     }
+}
+
+void
+flushmmucache(void)
+{
+    mem_tlb_flush(0);
+    tlb_stats.flush_full++;
     mmuflush++;
+    mem_exec_gen++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
+/* A CR3 write only drops the global pages if CR4.PGE is clear. */
+void
+flushmmucache_cr3(void)
+{
+    mem_tlb_flush(!!(cr4 & CR4_PGE));
+    tlb_stats.flush_cr3++;
+    mmuflush++;
+    mem_exec_gen++;
 
     pccache  = (uint32_t) 0xffffffff;
     pccache2 = (uint8_t *) 0xffffffff;
@@ -216,13 +316,15 @@ flushmmucache(void)
 void
 flushmmucache_write(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
+    for (int c = 0; c < cachesize; c++) {
         if (writelookup[c] != (int) 0xffffffff) {
             page_lookup[writelookup[c]]  = NULL;
             writelookup2[writelookup[c]] = LOOKUP_INV;
             writelookup[c]               = 0xffffffff;
+            writelookup_flags[c]         = 0;
         }
     }
+    tlb_stats.flush_write++;
     mmuflush++;
 }
 
@@ -230,6 +332,7 @@ void
 flushmmucache_pc(void)
 {
     mmuflush++;
+    mem_exec_gen++;
 
     pccache  = (uint32_t) 0xffffffff;
     pccache2 = (uint8_t *) 0xffffffff;
@@ -242,17 +345,9 @@ flushmmucache_pc(void)
 void
 flushmmucache_nopc(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookup[c]              = 0xffffffff;
-        }
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
-        }
-    }
+    mem_tlb_flush(0);
+    tlb_stats.flush_nopc++;
+    mem_exec_gen++;
 }
 
 void
@@ -260,13 +355,14 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
 {
     const page_t *page_target = &pages[addr >> 12];
 
-    for (uint16_t c = 0; c < 256; c++) {
+    for (int c = 0; c < cachesize; c++) {
         if (writelookup[c] != (int) 0xffffffff) {
             uintptr_t target = (uintptr_t) &ram[(uintptr_t) (addr & ~0xfff) - (virt & ~0xfff)];
             if (writelookup2[writelookup[c]] == target || page_lookup[writelookup[c]] == page_target) {
                 writelookup2[writelookup[c]] = LOOKUP_INV;
                 page_lookup[writelookup[c]]  = NULL;
                 writelookup[c]               = 0xffffffff;
+                writelookup_flags[c]         = 0;
             }
         }
     }
@@ -319,6 +415,9 @@ mmutranslatereal_normal(uint32_t addr, int rw)
 
         rammap(addr2) |= (rw ? 0x60 : 0x20);
 
+        mmu_last_page   = addr >> 12;
+        mmu_last_global = (cr4 & CR4_PGE) && (temp & 0x100);
+
         uint64_t page = temp & ~0x3fffff;
         if (cpu_features & CPU_FEATURE_PSE36)
             page |= (uint64_t) (temp & 0x1e000) << 19;
@@ -342,6 +441,9 @@ mmutranslatereal_normal(uint32_t addr, int rw)
     rammap(addr2) |= 0x20;
     rammap((temp2 & ~0xfff) + ((addr >> 10) & 0xffc)) |= (rw ? 0x60 : 0x20);
 
+    mmu_last_page   = addr >> 12;
+    mmu_last_global = (cr4 & CR4_PGE) && (temp & 0x100);
+
     return (uint64_t) ((temp & ~0xfff) + (addr & 0xfff));
 }
 
@@ -404,6 +506,9 @@ mmutranslatereal_pae(uint32_t addr, int rw)
         }
         rammap64(addr3) |= (rw ? 0x60 : 0x20);
 
+        mmu_last_page   = addr >> 12;
+        mmu_last_global = (cr4 & CR4_PGE) && (temp & 0x100);
+
         return ((temp & ~0x1fffffULL) + (addr & 0x1fffffULL)) & 0x000000ffffffffffULL;
     }
 
@@ -425,6 +530,9 @@ mmutranslatereal_pae(uint32_t addr, int rw)
     rammap64(addr3) |= 0x20;
     rammap64(addr4) |= (rw ? 0x60 : 0x20);
 
+    mmu_last_page   = addr >> 12;
+    mmu_last_global = (cr4 & CR4_PGE) && (temp & 0x100);
+
     return ((temp & ~0xfffULL) + ((uint64_t) (addr & 0xfff))) & 0x000000ffffffffffULL;
 }
 
@@ -567,25 +675,64 @@ mem_addr_translate(uint32_t addr, uint32_t chunk_start, uint32_t len)
     return chunk_start + (addr & mask);
 }
 
+/*
+ * Pick the next soft TLB slot to replace: global pages are passed
+ * over once, so that kernel mappings shared by every process outlive
+ * the per-process ones.
+ */
+static __inline int
+mem_tlb_victim(int *next, uint8_t *flags)
+{
+    int c;
+
+    for (int i = 0; i < cachesize; i++) {
+        c     = *next;
+        *next = (c + 1) & (cachesize - 1);
+        if (!(flags[c] & TLB_CHANCE))
+            return c;
+        flags[c] &= ~TLB_CHANCE;
+    }
+
+    c     = *next;
+    *next = (c + 1) & (cachesize - 1);
+    return c;
+}
+
+/* Flags for a new entry for virt, from the translation that just produced it. */
+static __inline uint8_t
+mem_tlb_new_flags(uint32_t virt)
+{
+    if ((cr0 & 0x80000000) && mmu_last_global && ((virt >> 12) == mmu_last_page))
+        return TLB_GLOBAL | TLB_CHANCE;
+
+    return 0;
+}
+
 void
 addreadlookup(uint32_t virt, uint32_t phys)
 {
+    int c;
+
     if (virt == 0xffffffff)
         return;
 
     if (readlookup2[virt >> 12] != (uintptr_t) LOOKUP_INV)
         return;
 
-    if (readlookup[readlnext] != (int) 0xffffffff) {
-        if ((readlookup[readlnext] == ((es + DI) >> 12)) || (readlookup[readlnext] == ((es + EDI) >> 12)))
+    c = mem_tlb_victim(&readlnext, readlookup_flags);
+
+    if (readlookup[c] != (int) 0xffffffff) {
+        if ((readlookup[c] == ((es + DI) >> 12)) || (readlookup[c] == ((es + EDI) >> 12)))
             uncached = 1;
-        readlookup2[readlookup[readlnext]] = LOOKUP_INV;
+        readlookup2[readlookup[c]] = LOOKUP_INV;
+        tlb_stats.evictions++;
     }
 
     readlookup2[virt >> 12] = (uintptr_t) &ram[(uintptr_t) (phys & ~0xFFF) - (uintptr_t) (virt & ~0xfff)];
 
-    readlookup[readlnext++] = virt >> 12;
-    readlnext &= (cachesize - 1);
+    readlookup[c]       = virt >> 12;
+    readlookup_flags[c] = mem_tlb_new_flags(virt);
+    tlb_stats.read_fills++;
 
     cycles -= 9;
 }
@@ -593,15 +740,20 @@ addreadlookup(uint32_t virt, uint32_t phys)
 void
 addwritelookup(uint32_t virt, uint32_t phys)
 {
+    int c;
+
     if (virt == 0xffffffff)
         return;
 
     if (page_lookup[virt >> 12])
         return;
 
-    if (writelookup[writelnext] != -1) {
-        page_lookup[writelookup[writelnext]]  = NULL;
-        writelookup2[writelookup[writelnext]] = LOOKUP_INV;
+    c = mem_tlb_victim(&writelnext, writelookup_flags);
+
+    if (writelookup[c] != -1) {
+        page_lookup[writelookup[c]]  = NULL;
+        writelookup2[writelookup[c]] = LOOKUP_INV;
+        tlb_stats.evictions++;
     }
 
 #ifdef USE_NEW_DYNAREC
@@ -623,8 +775,9 @@ addwritelookup(uint32_t virt, uint32_t phys)
         writelookup2[virt >> 12] = (uintptr_t) &ram[(uintptr_t) (phys & ~0xFFF) - (uintptr_t) (virt & ~0xfff)];
     }
 
-    writelookup[writelnext++] = virt >> 12;
-    writelnext &= (cachesize - 1);
+    writelookup[c]       = virt >> 12;
+    writelookup_flags[c] = mem_tlb_new_flags(virt);
+    tlb_stats.write_fills++;
 
     cycles -= 9;
 }
@@ -751,8 +904,8 @@ write_mem_w(uint32_t addr, uint16_t val)
     resub_cycles(old_cycles);
 }
 
-uint8_t
-readmembl(uint32_t addr)
+static __inline uint8_t
+readmembl_slow(uint32_t addr)
 {
     mem_mapping_t *map;
     uint64_t       a;
@@ -783,8 +936,20 @@ readmembl(uint32_t addr)
     return 0xff;
 }
 
-void
-writemembl(uint32_t addr, uint8_t val)
+/* The soft TLB miss paths are wrapped to account their time to the profiler. */
+uint8_t
+readmembl(uint32_t addr)
+{
+    int     prof_old = prof_enter(PROF_MEM);
+    uint8_t ret      = readmembl_slow(addr);
+
+    prof_leave(prof_old);
+
+    return ret;
+}
+
+static __inline void
+writemembl_slow(uint32_t addr, uint8_t val)
 {
     mem_mapping_t *map;
     uint64_t       a;
@@ -818,6 +983,16 @@ writemembl(uint32_t addr, uint8_t val)
         map->write_b(addr, val, map->priv);
 }
 
+void
+writemembl(uint32_t addr, uint8_t val)
+{
+    int prof_old = prof_enter(PROF_MEM);
+
+    writemembl_slow(addr, val);
+
+    prof_leave(prof_old);
+}
+
 /* Read a byte from memory without MMU translation - result of previous MMU translation passed as value. */
 uint8_t
 readmembl_no_mmut(uint32_t addr, uint32_t a64)
@@ -871,8 +1046,8 @@ writemembl_no_mmut(uint32_t addr, uint32_t a64, uint8_t val)
         map->write_b(addr, val, map->priv);
 }
 
-uint16_t
-readmemwl(uint32_t addr)
+static __inline uint16_t
+readmemwl_slow(uint32_t addr)
 {
     mem_mapping_t *map;
     uint64_t       a;
@@ -931,8 +1106,19 @@ readmemwl(uint32_t addr)
     return 0xffff;
 }
 
-void
-writememwl(uint32_t addr, uint16_t val)
+uint16_t
+readmemwl(uint32_t addr)
+{
+    int      prof_old = prof_enter(PROF_MEM);
+    uint16_t ret      = readmemwl_slow(addr);
+
+    prof_leave(prof_old);
+
+    return ret;
+}
+
+static __inline void
+writememwl_slow(uint32_t addr, uint16_t val)
 {
     mem_mapping_t *map;
     uint64_t       a;
@@ -1007,6 +1193,16 @@ writememwl(uint32_t addr, uint16_t val)
     }
 }
 
+void
+writememwl(uint32_t addr, uint16_t val)
+{
+    int prof_old = prof_enter(PROF_MEM);
+
+    writememwl_slow(addr, val);
+
+    prof_leave(prof_old);
+}
+
 /* Read a word from memory without MMU translation - results of previous MMU translation passed as array. */
 uint16_t
 readmemwl_no_mmut(uint32_t addr, uint32_t *a64)
@@ -1106,8 +1302,8 @@ writememwl_no_mmut(uint32_t addr, uint32_t *a64, uint16_t val)
     }
 }
 
-uint32_t
-readmemll(uint32_t addr)
+static __inline uint32_t
+readmemll_slow(uint32_t addr)
 {
     mem_mapping_t *map;
     int            i;
@@ -1182,8 +1378,19 @@ readmemll(uint32_t addr)
     return 0xffffffff;
 }
 
-void
-writememll(uint32_t addr, uint32_t val)
+uint32_t
+readmemll(uint32_t addr)
+{
+    int      prof_old = prof_enter(PROF_MEM);
+    uint32_t ret      = readmemll_slow(addr);
+
+    prof_leave(prof_old);
+
+    return ret;
+}
+
+static __inline void
+writememll_slow(uint32_t addr, uint32_t val)
 {
     mem_mapping_t *map;
     int            i;
@@ -1277,6 +1484,16 @@ writememll(uint32_t addr, uint32_t val)
     }
 }
 
+void
+writememll(uint32_t addr, uint32_t val)
+{
+    int prof_old = prof_enter(PROF_MEM);
+
+    writememll_slow(addr, val);
+
+    prof_leave(prof_old);
+}
+
 /* Read a long from memory without MMU translation - results of previous MMU translation passed as array. */
 uint32_t
 readmemll_no_mmut(uint32_t addr, uint32_t *a64)
@@ -1384,8 +1601,8 @@ writememll_no_mmut(uint32_t addr, uint32_t *a64, uint32_t val)
     }
 }
 
-uint64_t
-readmemql(uint32_t addr)
+static __inline uint64_t
+readmemql_slow(uint32_t addr)
 {
     mem_mapping_t *map;
     int            i;
@@ -1470,8 +1687,19 @@ readmemql(uint32_t addr)
     return 0xffffffffffffffffULL;
 }
 
-void
-writememql(uint32_t addr, uint64_t val)
+uint64_t
+readmemql(uint32_t addr)
+{
+    int      prof_old = prof_enter(PROF_MEM);
+    uint64_t ret      = readmemql_slow(addr);
+
+    prof_leave(prof_old);
+
+    return ret;
+}
+
+static __inline void
+writememql_slow(uint32_t addr, uint64_t val)
 {
     mem_mapping_t *map;
     int            i;
@@ -1570,6 +1798,16 @@ writememql(uint32_t addr, uint64_t val)
     }
 }
 
+void
+writememql(uint32_t addr, uint64_t val)
+{
+    int prof_old = prof_enter(PROF_MEM);
+
+    writememql_slow(addr, val);
+
+    prof_leave(prof_old);
+}
+
 void
 do_mmutranslate(uint32_t addr, uint32_t *a64, int num, int write)
 {
@@ -1772,6 +2010,37 @@ mem_write_phys(void *src, uint32_t addr, int transfer_size)
     }
 }
 
+/*
+ * Return a host pointer to the bus-side memory at addr, if it is plain
+ * RAM that can be accessed directly, NULL otherwise. In both cases, len
+ * receives the number of bytes up to the end of the granule (or of the
+ * mirrored block, if smaller), which is how far the answer holds.
+ */
+uint8_t *
+mem_get_phys_ptr(uint32_t addr, uint32_t *len, int write)
+{
+    mem_mapping_t *map;
+    uint32_t       off;
+    uint32_t       rem = MEM_GRANULARITY_MASK - (addr & MEM_GRANULARITY_MASK);
+
+    map = write ? write_mapping_bus[addr >> MEM_GRANULARITY_BITS] : read_mapping_bus[addr >> MEM_GRANULARITY_BITS];
+
+    mem_logical_addr = 0xffffffff;
+
+    if ((map == NULL) || (map->exec == NULL) ||
+        (!cpu_use_exec && (is_pcjr || (write ? (map->write_b != mem_write_ram) : (map->read_b != mem_read_ram))))) {
+        *len = rem + 1;
+        return NULL;
+    }
+
+    off = (addr - map->base) & map->mask;
+    if ((map->mask - off) < rem)
+        rem = map->mask - off;
+    *len = rem + 1;
+
+    return &(map->exec[off]);
+}
+
 uint8_t
 mem_read_ram(uint32_t addr, UNUSED(void *priv))
 {
@@ -2279,19 +2548,220 @@ mem_mapping_access_allowed(uint32_t flags, uint16_t access)
     return ret;
 }
 
+static void
+mem_index_insert(mem_index_t *idx, mem_mapping_t *map)
+{
+    int i;
+
+    if (idx->num == idx->max) {
+        idx->max  = idx->max ? (idx->max << 1) : 8;
+        idx->maps = (mem_mapping_t **) realloc(idx->maps, idx->max * sizeof(mem_mapping_t *));
+        if (idx->maps == NULL)
+            fatal("mem_index_insert(): Out of memory\n");
+    }
+
+    /* Mappings are nearly always added last, so search from the end. */
+    for (i = idx->num; (i > 0) && (idx->maps[i - 1]->seq > map->seq); i--)
+        idx->maps[i] = idx->maps[i - 1];
+    idx->maps[i] = map;
+    idx->num++;
+}
+
+static void
+mem_index_remove(mem_index_t *idx, mem_mapping_t *map)
+{
+    for (int i = 0; i < idx->num; i++) {
+        if (idx->maps[i] == map) {
+            memmove(&idx->maps[i], &idx->maps[i + 1], (idx->num - i - 1) * sizeof(mem_mapping_t *));
+            idx->num--;
+            return;
+        }
+    }
+}
+
+static void
+mem_index_clear(void)
+{
+    for (int i = 0; i < MEM_INDEX_SIZE; i++)
+        mem_index[i].num = 0;
+    mem_index_wide.num = 0;
+
+    /* Anything with an older sequence number is no longer in the list. */
+    mem_seq_base = mem_mapping_seq;
+}
+
+static void
+mem_mapping_unindex(mem_mapping_t *map)
+{
+    if (map->idx_state == MEM_INDEX_BUCKETS) {
+        for (uint32_t i = map->idx_first; i <= map->idx_last; i++)
+            mem_index_remove(&mem_index[i], map);
+    } else if (map->idx_state == MEM_INDEX_WIDE)
+        mem_index_remove(&mem_index_wide, map);
+
+    map->idx_state = MEM_INDEX_NONE;
+}
+
+/* File the mapping under its current range, called whenever that changes. */
+static void
+mem_mapping_index(mem_mapping_t *map)
+{
+    uint64_t end;
+
+    if (map->seq <= mem_seq_base)
+        return;
+
+    mem_mapping_unindex(map);
+
+    if (map->size == 0x00000000)
+        return;
+
+    end            = (uint64_t) map->base + (uint64_t) map->size - 1ULL;
+    map->idx_first = map->base >> MEM_INDEX_BITS;
+    map->idx_last  = (end >= 0x100000000ULL) ? (MEM_INDEX_SIZE - 1) : (uint32_t) (end >> MEM_INDEX_BITS);
+
+    if (map->base_ignore || ((map->idx_last - map->idx_first) >= MEM_INDEX_SPAN_MAX)) {
+        mem_index_insert(&mem_index_wide, map);
+        map->idx_state = MEM_INDEX_WIDE;
+    } else {
+        for (uint32_t i = map->idx_first; i <= map->idx_last; i++)
+            mem_index_insert(&mem_index[i], map);
+        map->idx_state = MEM_INDEX_BUCKETS;
+    }
+}
+
+static void
+mem_index_add_cand(mem_mapping_t *map)
+{
+    if (map->idx_stamp == mem_index_stamp)
+        return;
+    map->idx_stamp = mem_index_stamp;
+
+    mem_index_insert(&mem_index_cand, map);
+}
+
+/*
+ * Gather the mappings that can overlap the range, in list order, or
+ * return 0 if the range is big enough that the whole list should be
+ * walked instead.
+ */
+static int
+mem_index_gather(uint64_t base, uint64_t size)
+{
+    uint64_t first = base >> MEM_INDEX_BITS;
+    uint64_t last  = (base + size - 1ULL) >> MEM_INDEX_BITS;
+
+    if (((last - first) >= MEM_INDEX_RECALC_MAX) || (last >= MEM_INDEX_SIZE))
+        return 0;
+
+    mem_index_stamp++;
+    mem_index_cand.num = 0;
+
+    for (uint64_t i = first; i <= last; i++) {
+        for (int j = 0; j < mem_index[i].num; j++)
+            mem_index_add_cand(mem_index[i].maps[j]);
+    }
+    for (int j = 0; j < mem_index_wide.num; j++)
+        mem_index_add_cand(mem_index_wide.maps[j]);
+
+    return 1;
+}
+
+static void
+mem_mapping_recalc_map(mem_mapping_t *map, uint64_t base, uint64_t size)
+{
+    int      n;
+    uint64_t c;
+    uint8_t  wp;
+
+    /* In range? */
+    if (map->enable && (uint64_t) map->base < ((uint64_t) base + (uint64_t) size) &&
+        ((uint64_t) map->base + (uint64_t) map->size) > (uint64_t) base) {
+        uint64_t i_a   = ((~map->base_ignore) & 0xffffffffULL) + 0x00000001ULL;
+        uint64_t i_s   = 0x00000000ULL;
+        uint64_t i_e   = map->base_ignore;
+        uint64_t i_c   = 0x00000000ULL;
+        uint64_t start = (map->base < base) ? map->base : base;
+        uint64_t end   = (((uint64_t) map->base + (uint64_t) map->size) < (base + size)) ?
+                         ((uint64_t) map->base + (uint64_t) map->size) : (base + size);
+        if (start < map->base)
+            start = map->base;
+
+        if (i_e == 0x00000000ULL) {
+            for (c = start; c < end; c += MEM_GRANULARITY_SIZE) {
+                /* CPU */
+                n = !!in_smm;
+                wp = _mem_wp[c >> MEM_GRANULARITY_BITS];
+
+                if (map->exec && mem_mapping_access_allowed(map->flags,
+                                 _mem_state[c >> MEM_GRANULARITY_BITS].states[n].x))
+                    _mem_exec[c >> MEM_GRANULARITY_BITS] = map->exec + (c - map->base);
+                if (!wp && (map->write_b || map->write_w || map->write_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
+                    write_mapping[c >> MEM_GRANULARITY_BITS] = map;
+                if ((map->read_b || map->read_w || map->read_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
+                    read_mapping[c >> MEM_GRANULARITY_BITS] = map;
+
+                /* Bus */
+                n |= STATE_BUS;
+                wp = _mem_wp_bus[c >> MEM_GRANULARITY_BITS];
+
+                if (!wp && (map->write_b || map->write_w || map->write_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
+                    write_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
+                if ((map->read_b || map->read_w || map->read_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
+                    read_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
+            }
+        } else  for (i_c = i_s; i_c <= i_e; i_c += i_a) {
+            for (c = (start + i_c); c < (end + i_c); c += MEM_GRANULARITY_SIZE) {
+                /* CPU */
+                n = (!!in_smm) || (is_cxsmm && (ccr1 & CCR1_SMAC));
+                wp = _mem_wp[c >> MEM_GRANULARITY_BITS];
+
+                if (map->exec && mem_mapping_access_allowed(map->flags,
+                                                            _mem_state[c >> MEM_GRANULARITY_BITS].states[n].x))
+                    _mem_exec[c >> MEM_GRANULARITY_BITS] = map->exec + (c - map->base);
+                if (!wp && (map->write_b || map->write_w || map->write_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
+                    write_mapping[c >> MEM_GRANULARITY_BITS] = map;
+                if ((map->read_b || map->read_w || map->read_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
+                    read_mapping[c >> MEM_GRANULARITY_BITS] = map;
+
+                /* Bus */
+                n |= STATE_BUS;
+                wp = _mem_wp_bus[c >> MEM_GRANULARITY_BITS];
+
+                if (!wp && (map->write_b || map->write_w || map->write_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
+                    write_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
+                if ((map->read_b || map->read_w || map->read_l) &&
+                    mem_mapping_access_allowed(map->flags,
+                                               _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
+                    read_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
+            }
+        }
+    }
+}
+
 void
 mem_mapping_recalc(uint64_t base, uint64_t size)
 {
     mem_mapping_t *map;
-    int            n;
     uint64_t       c;
-    uint8_t        wp;
 
     if (!size || (base_mapping == NULL))
         return;
 
-    map = base_mapping;
-
     /* Clear out old mappings. */
     for (c = base; c < base + size; c += MEM_GRANULARITY_SIZE) {
         _mem_exec[c >> MEM_GRANULARITY_BITS]         = NULL;
@@ -2301,86 +2771,13 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
         read_mapping_bus[c >> MEM_GRANULARITY_BITS]  = NULL;
     }
 
-    /* Walk mapping list. */
-    while (map != NULL) {
-        /* In range? */
-        if (map->enable && (uint64_t) map->base < ((uint64_t) base + (uint64_t) size) &&
-            ((uint64_t) map->base + (uint64_t) map->size) > (uint64_t) base) {
-            uint64_t i_a   = ((~map->base_ignore) & 0xffffffffULL) + 0x00000001ULL;
-            uint64_t i_s   = 0x00000000ULL;
-            uint64_t i_e   = map->base_ignore;
-            uint64_t i_c   = 0x00000000ULL;
-            uint64_t start = (map->base < base) ? map->base : base;
-            uint64_t end   = (((uint64_t) map->base + (uint64_t) map->size) < (base + size)) ?
-                             ((uint64_t) map->base + (uint64_t) map->size) : (base + size);
-            if (start < map->base)
-                start = map->base;
-
-            if (i_e == 0x00000000ULL) {
-                for (c = start; c < end; c += MEM_GRANULARITY_SIZE) {
-                    /* CPU */
-                    n = !!in_smm;
-                    wp = _mem_wp[c >> MEM_GRANULARITY_BITS];
-
-                    if (map->exec && mem_mapping_access_allowed(map->flags,
-                                     _mem_state[c >> MEM_GRANULARITY_BITS].states[n].x))
-                        _mem_exec[c >> MEM_GRANULARITY_BITS] = map->exec + (c - map->base);
-                    if (!wp && (map->write_b || map->write_w || map->write_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
-                        write_mapping[c >> MEM_GRANULARITY_BITS] = map;
-                    if ((map->read_b || map->read_w || map->read_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
-                        read_mapping[c >> MEM_GRANULARITY_BITS] = map;
-
-                    /* Bus */
-                    n |= STATE_BUS;
-                    wp = _mem_wp_bus[c >> MEM_GRANULARITY_BITS];
-
-                    if (!wp && (map->write_b || map->write_w || map->write_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
-                        write_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
-                    if ((map->read_b || map->read_w || map->read_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
-                        read_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
-                }
-            } else  for (i_c = i_s; i_c <= i_e; i_c += i_a) {
-                for (c = (start + i_c); c < (end + i_c); c += MEM_GRANULARITY_SIZE) {
-                    /* CPU */
-                    n = (!!in_smm) || (is_cxsmm && (ccr1 & CCR1_SMAC));
-                    wp = _mem_wp[c >> MEM_GRANULARITY_BITS];
-
-                    if (map->exec && mem_mapping_access_allowed(map->flags,
-                                                                _mem_state[c >> MEM_GRANULARITY_BITS].states[n].x))
-                        _mem_exec[c >> MEM_GRANULARITY_BITS] = map->exec + (c - map->base);
-                    if (!wp && (map->write_b || map->write_w || map->write_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
-                        write_mapping[c >> MEM_GRANULARITY_BITS] = map;
-                    if ((map->read_b || map->read_w || map->read_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
-                        read_mapping[c >> MEM_GRANULARITY_BITS] = map;
-
-                    /* Bus */
-                    n |= STATE_BUS;
-                    wp = _mem_wp_bus[c >> MEM_GRANULARITY_BITS];
-
-                    if (!wp && (map->write_b || map->write_w || map->write_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
-                        write_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
-                    if ((map->read_b || map->read_w || map->read_l) &&
-                        mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
-                        read_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
-                }
-            }
-        }
-        map = map->next;
+    if (mem_index_gather(base, size)) {
+        for (int i = 0; i < mem_index_cand.num; i++)
+            mem_mapping_recalc_map(mem_index_cand.maps[i], base, size);
+    } else {
+        /* Walk mapping list. */
+        for (map = base_mapping; map != NULL; map = map->next)
+            mem_mapping_recalc_map(map, base, size);
     }
 
     flushmmucache_nopc();
@@ -2485,6 +2882,8 @@ mem_mapping_set(mem_mapping_t *map,
     map->next    = NULL;
     mem_log("mem_mapping_add(): Linked list structure: %08X -> %08X -> %08X\n", map->prev, map, map->next);
 
+    mem_mapping_index(map);
+
     /* If the mapping is disabled, there is no need to recalc anything. */
     if (size != 0x00000000)
         mem_mapping_recalc(map->base, map->size);
@@ -2532,6 +2931,9 @@ mem_mapping_add(mem_mapping_t *map,
     }
     last_mapping = map;
 
+    map->seq       = ++mem_mapping_seq;
+    map->idx_state = MEM_INDEX_NONE;
+
     mem_mapping_set(map, base, size, read_b, read_w, read_l,
                     write_b, write_w, write_l, exec, fl, priv);
 }
@@ -2585,6 +2987,7 @@ mem_mapping_set_addr(mem_mapping_t *map, uint32_t base, uint32_t size)
     map->enable = 1;
     map->base   = base;
     map->size   = size;
+    mem_mapping_index(map);
 
     mem_mapping_recalc(map->base, map->size);
 }
@@ -2599,6 +3002,7 @@ mem_mapping_set_base_ignore(mem_mapping_t *map, uint32_t base_ignore)
     /* Set new mapping. */
     map->enable      = 1;
     map->base_ignore = base_ignore;
+    mem_mapping_index(map);
 
     mem_mapping_recalc(map->base, map->size);
 }
@@ -2721,6 +3125,7 @@ mem_close(void)
     }
 
     base_mapping = last_mapping = 0;
+    mem_index_clear();
 }
 
 static void
@@ -2742,7 +3147,60 @@ mem_init_ram_mapping(mem_mapping_t *mapping, uint32_t base, uint32_t size)
 void
 mem_zero(void)
 {
-    memset(ram, 0x00, ram_size + 16);
+    /* Do not dirty every page of a shared RAM image. */
+    if (!ram_is_image)
+        memset(ram, 0x00, ram_size + 16);
+}
+
+/* Returns 1 if the configured RAM image exists and matches the RAM size. */
+static int
+mem_ram_image_valid(size_t size)
+{
+    FILE   *fp;
+    int64_t len;
+
+    fp = plat_fopen(mem_ram_image, "rb");
+    if (fp == NULL)
+        return 0;
+
+    fseeko64(fp, 0, SEEK_END);
+    len = ftello64(fp);
+    fclose(fp);
+
+    return (len == (int64_t) size);
+}
+
+/* Free the RAM block, reporting how much of an image was shared. */
+static void
+mem_free_ram(void)
+{
+    uint64_t shared;
+    uint64_t priv;
+
+    if (ram_is_image && !plat_mmap_stats(ram, ram_size + 16, &shared, &priv))
+        pclog("MEM: RAM image \"%s\": %" PRIu64 " shared pages, %" PRIu64 " private pages\n",
+              mem_ram_image, shared, priv);
+
+    plat_munmap(ram, ram_size + 16);
+    ram          = NULL;
+    ram_size     = 0;
+    ram_is_image = 0;
+}
+
+/* Print the shared/private page counts of an image-backed RAM block. */
+void
+mem_ram_image_stats(void)
+{
+    uint64_t shared;
+    uint64_t priv;
+
+    if (!ram_is_image)
+        pclog("MEM: RAM is not backed by an image\n");
+    else if (plat_mmap_stats(ram, ram_size + 16, &shared, &priv))
+        pclog("MEM: Page statistics are not available on this platform\n");
+    else
+        pclog("MEM: RAM image \"%s\": %" PRIu64 " shared pages, %" PRIu64 " private pages\n",
+              mem_ram_image, shared, priv);
 }
 
 /* Reset the memory state. */
@@ -2771,22 +3229,36 @@ mem_reset(void)
         pages = NULL;
     }
 
-    if (ram != NULL) {
-        plat_munmap(ram, ram_size);
-        ram      = NULL;
-        ram_size = 0;
-    }
+    if (ram != NULL)
+        mem_free_ram();
 
     m = 1024UL * (size_t) mem_size;
 
     ram_size = m;
-    /* Allocate 16 extra bytes of RAM to mitigate some dynarec recompiler memory access quirks. */
-    ram      = (uint8_t *) plat_mmap(ram_size + 16, 0); /* allocate and clear the RAM block */
+    /*
+     * If a RAM image is configured, map it copy-on-write, so that
+     * every instance started from the same image shares the pages
+     * it never writes to.
+     */
+    if (mem_ram_image[0] != 0x00) {
+        if (mem_ram_image_valid(ram_size)) {
+            ram          = (uint8_t *) plat_mmap_file(mem_ram_image, ram_size + 16);
+            ram_is_image = (ram != NULL);
+            if (ram == NULL)
+                pclog("MEM: Unable to map RAM image \"%s\", using private RAM\n", mem_ram_image);
+        } else {
+            mem_log("MEM: RAM image \"%s\" missing or of the wrong size, using private RAM\n", mem_ram_image);
+        }
+    }
     if (ram == NULL) {
-        fatal("Failed to allocate RAM block. Make sure you have enough RAM available.\n");
-        return;
+        /* Allocate 16 extra bytes of RAM to mitigate some dynarec recompiler memory access quirks. */
+        ram = (uint8_t *) plat_mmap(ram_size + 16, 0); /* allocate and clear the RAM block */
+        if (ram == NULL) {
+            fatal("Failed to allocate RAM block. Make sure you have enough RAM available.\n");
+            return;
+        }
+        memset(ram, 0x00, ram_size + 16);
     }
-    memset(ram, 0x00, ram_size + 16);
 
     /*
      * Allocate the page table based on how much RAM we have.
@@ -2857,6 +3329,7 @@ mem_reset(void)
     memset(read_mapping_bus, 0x00, sizeof(read_mapping_bus));
 
     base_mapping = last_mapping = NULL;
+    mem_index_clear();
 
     /* Set the entire memory space as external. */
     memset(_mem_state, 0x00, sizeof(_mem_state));
@@ -2902,6 +3375,153 @@ mem_reset(void)
 #endif
 }
 
+/* 64-bit FNV-1a, used to tell RAM images of the same size apart. */
+#define MEM_FNV64_BASIS 0xcbf29ce484222325ULL
+#define MEM_FNV64_PRIME 0x00000100000001b3ULL
+
+static uint64_t
+mem_fnv64(uint64_t hash, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= MEM_FNV64_PRIME;
+    }
+
+    return hash;
+}
+
+/*
+ * Hash the RAM image file itself rather than the mapped RAM, which the
+ * machine may already have written to since it was reset.
+ */
+static int
+mem_ram_image_hash(uint64_t *size, uint64_t *hash)
+{
+    uint8_t buf[65536];
+    FILE   *fp;
+    size_t  len;
+
+    fp = plat_fopen(mem_ram_image, "rb");
+    if (fp == NULL)
+        return 0;
+
+    *size = 0;
+    *hash = MEM_FNV64_BASIS;
+    while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        *size += len;
+        *hash = mem_fnv64(*hash, buf, len);
+    }
+    fclose(fp);
+
+    return 1;
+}
+
+/*
+ * Write the RAM contents out as the golden image for copy-on-write
+ * instances. Other instances may have the image mapped, so it is never
+ * rewritten in place: the new one is written next to it and renamed
+ * over it, running instances keep the old file.
+ */
+static int
+mem_ram_image_write(void)
+{
+    char   tmp[sizeof(mem_ram_image) + 4];
+    FILE  *fp;
+    size_t ret;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", mem_ram_image);
+
+    fp = plat_fopen(tmp, "wb");
+    if (fp == NULL)
+        return 0;
+
+    ret = fwrite(ram, 1, ram_size, fp);
+    if (fclose(fp) != 0)
+        ret = 0;
+
+    if ((ret != ram_size) || (rename(tmp, mem_ram_image) != 0)) {
+        plat_remove(tmp);
+        return 0;
+    }
+
+    return 1;
+}
+
+void
+mem_savestate(savestate_t *st)
+{
+    uint64_t size       = ram_size;
+    uint8_t  image      = 0;
+    uint64_t image_size = 0;
+    uint64_t image_hash = 0;
+    uint64_t cur_size;
+    uint64_t cur_hash;
+
+    savestate_var(st, size);
+    if (!st->error && (size != ram_size)) {
+        pclog("SAVESTATE: RAM size mismatch\n");
+        st->error = 1;
+        return;
+    }
+
+    /*
+     * Saving with a RAM image configured but not in use creates the
+     * image, the state then only refers to it. Restoring such a state
+     * requires the image to be mapped, and since it was mapped from
+     * the very same contents, the RAM does not need to be touched.
+     * The size and hash of the image are recorded, so that a state is
+     * never restored over a different image of the same size.
+     */
+    if (st->saving && (mem_ram_image[0] != 0x00) && !ram_is_image) {
+        image = mem_ram_image_write();
+        if (image) {
+            image_size = ram_size;
+            image_hash = mem_fnv64(MEM_FNV64_BASIS, ram, ram_size);
+        }
+    }
+    savestate_var(st, image);
+
+    if (image) {
+        savestate_var(st, image_size);
+        savestate_var(st, image_hash);
+
+        if (!st->saving && !st->error) {
+            if (!ram_is_image) {
+                pclog("SAVESTATE: State requires the RAM image \"%s\"\n", mem_ram_image);
+                st->error = 1;
+                return;
+            }
+
+            if (!mem_ram_image_hash(&cur_size, &cur_hash) ||
+                (cur_size != image_size) || (cur_hash != image_hash)) {
+                pclog("SAVESTATE: RAM image \"%s\" is not the one the state was saved with\n", mem_ram_image);
+                st->error = 1;
+                return;
+            }
+        }
+    } else
+        savestate_rw(st, ram, ram_size);
+    savestate_var(st, _mem_state);
+    savestate_var(st, mem_a20_key);
+    savestate_var(st, mem_a20_alt);
+    savestate_var(st, shadowbios);
+    savestate_var(st, shadowbios_write);
+
+    if (!st->saving && !st->error) {
+        /* Force mem_a20_recalc() to see a state change. */
+        mem_a20_state = !(mem_a20_key | mem_a20_alt);
+        mem_a20_recalc();
+
+        mem_mapping_recalc(0ULL, ((uint64_t) addr_space_size) << 12);
+
+        /* RAM was replaced behind the back of the TLB and the recompiler. */
+        flushmmucache();
+#ifdef USE_DYNAREC
+        codegen_reset();
+#endif
+    }
+}
+
 void
 mem_init(void)
 {
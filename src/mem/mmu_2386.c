@@ -271,6 +271,84 @@ mmutranslate_noabrt_2386(uint32_t addr, int rw)
     return (uint64_t) ((temp & ~0xfff) + (addr & 0xfff));
 }
 
+/* Code page of the 286/386 interpreter, see fetch_2386_fill(). */
+uint32_t fetch_2386_page = 0xffffffff;
+uint32_t fetch_2386_gen  = 0;
+uint8_t *fetch_2386_base = NULL;
+uint8_t  fetch_2386_user = 0;
+
+/* Whether the (present) page containing addr may be accessed at CPL 3. */
+static int
+fetch_2386_page_user(uint32_t addr)
+{
+    uint32_t pde = mem_readl_map((cr3 & ~0xfff) + ((addr >> 20) & 0xffc));
+
+    if ((pde & 0x80) && (cr4 & CR4_PSE))
+        return !!(pde & 4);
+
+    return !!(pde & mem_readl_map((pde & ~0xfff) + ((addr >> 10) & 0xffc)) & 4);
+}
+
+/*
+ * Look up the host pointer of the code page containing addr, so that
+ * instruction fetches from it can bypass the read mapping handlers.
+ * This is only done while no debug breakpoints are armed and the page is
+ * read through mem_read_ram(), the same condition as in
+ * mem_get_phys_ptr(); otherwise every fetch needs the full read path and
+ * NULL is returned.
+ *
+ * With paging on, the page is translated once here, setting the accessed
+ * bits or raising the page fault exactly like the first fetch from it
+ * would, and the entry then acts as a one-entry code TLB: it is keyed on
+ * the linear page and remembers whether the page is a supervisor one, so
+ * it is not used for such a page at CPL 3. Like a TLB entry, it stays
+ * valid until the next flush; flushmmucache(), flushmmucache_cr3() and
+ * INVLPG all bump mem_exec_gen, which is what the entry is checked against.
+ */
+uint8_t *
+fetch_2386_fill(uint32_t addr)
+{
+#ifndef USE_GDBSTUB
+    const mem_mapping_t *map;
+    uint8_t             *exec;
+    uint64_t             a;
+    uint32_t             phys;
+    uint8_t              user = 1;
+#endif
+
+    fetch_2386_page = 0xffffffff;
+
+#ifdef USE_GDBSTUB
+    return NULL;
+#else
+    if (cpu_flush_pending || (dr[7] & 0x000000ff) || is_pcjr)
+        return NULL;
+
+    if (cr0 >> 31) {
+        a = mmutranslate_read_2386(addr);
+        if (a > 0xffffffffULL)
+            return NULL;
+
+        user = fetch_2386_page_user(addr);
+        phys = ((uint32_t) a) & rammask;
+    } else
+        phys = addr & rammask;
+
+    map = read_mapping[phys >> MEM_GRANULARITY_BITS];
+    if ((map == NULL) || (map->exec == NULL) || (map->read_b != mem_read_ram))
+        return NULL;
+
+    exec = map->exec + ((phys & ~MEM_GRANULARITY_MASK) - map->base);
+
+    fetch_2386_page = addr >> 12;
+    fetch_2386_gen  = mem_exec_gen;
+    fetch_2386_base = exec;
+    fetch_2386_user = user;
+
+    return exec;
+#endif
+}
+
 uint8_t
 readmembl_2386(uint32_t addr)
 {
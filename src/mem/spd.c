@@ -26,6 +26,8 @@
 #include <86box/version.h>
 #include <86box/machine.h>
 #include <86box/plat_unused.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 
 #define SPD_ROLLUP(x) ((x) >= 16 ? ((x) -15) : (x))
 
@@ -80,6 +82,15 @@ spd_init(UNUSED(const device_t *info))
     return &spd_modules;
 }
 
+static void
+spd_savestate(UNUSED(void *priv), savestate_t *st)
+{
+    for (uint8_t i = 0; i < SPD_MAX_SLOTS; i++) {
+        if (spd_modules[i])
+            i2c_eeprom_savestate(spd_modules[i]->eeprom, st);
+    }
+}
+
 int
 comp_ui16_rev(const void *elem1, const void *elem2)
 {
@@ -595,5 +606,6 @@ static const device_t spd_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = spd_savestate
 };
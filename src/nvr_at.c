@@ -218,6 +218,7 @@
  *   USA.
  */
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -236,6 +237,7 @@
 #include <86box/rom.h>
 #include <86box/device.h>
 #include <86box/nvr.h>
+#include <86box/savestate.h>
 
 /* RTC registers and bit definitions. */
 #define RTC_SECONDS        0
@@ -941,6 +943,23 @@ nvr_at_speed_changed(void *priv)
     timer_set_delay_u64(&nvr->onesec_time, (10000ULL * TIMER_USEC));
 }
 
+static void
+nvr_at_savestate(void *priv, savestate_t *st)
+{
+    nvr_t   *nvr   = (nvr_t *) priv;
+    local_t *local = (local_t *) nvr->data;
+
+    savestate_var(st, nvr->regs);
+    savestate_var(st, nvr->onesec_cnt);
+    savestate_timer(st, &nvr->onesec_time);
+
+    savestate_rw(st, local, offsetof(local_t, lock));
+    savestate_rw(st, local->lock, nvr->size);
+    savestate_rw(st, &local->count, offsetof(local_t, update_timer) - offsetof(local_t, count));
+    savestate_timer(st, &local->update_timer);
+    savestate_timer(st, &local->rtc_timer);
+}
+
 void
 nvr_at_handler(int set, uint16_t base, nvr_t *nvr)
 {
@@ -1256,7 +1275,8 @@ const device_t at_nvr_old_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t at_nvr_device = {
@@ -1270,7 +1290,8 @@ const device_t at_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t at_mb_nvr_device = {
@@ -1284,7 +1305,8 @@ const device_t at_mb_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t ps_nvr_device = {
@@ -1298,7 +1320,8 @@ const device_t ps_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t amstrad_nvr_device = {
@@ -1312,7 +1335,8 @@ const device_t amstrad_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t ibmat_nvr_device = {
@@ -1326,7 +1350,8 @@ const device_t ibmat_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t piix4_nvr_device = {
@@ -1340,7 +1365,8 @@ const device_t piix4_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t ps_no_nmi_nvr_device = {
@@ -1354,7 +1380,8 @@ const device_t ps_no_nmi_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t amstrad_no_nmi_nvr_device = {
@@ -1368,7 +1395,8 @@ const device_t amstrad_no_nmi_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t ami_1992_nvr_device = {
@@ -1382,7 +1410,8 @@ const device_t ami_1992_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t ami_1994_nvr_device = {
@@ -1396,7 +1425,8 @@ const device_t ami_1994_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t ami_1995_nvr_device = {
@@ -1410,7 +1440,8 @@ const device_t ami_1995_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t via_nvr_device = {
@@ -1424,7 +1455,8 @@ const device_t via_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t p6rp4_nvr_device = {
@@ -1438,7 +1470,8 @@ const device_t p6rp4_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t amstrad_megapc_nvr_device = {
@@ -1452,7 +1485,8 @@ const device_t amstrad_megapc_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t martin_nvr_device = {
@@ -1466,7 +1500,8 @@ const device_t martin_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
 
 const device_t elt_nvr_device = {
@@ -1480,5 +1515,6 @@ const device_t elt_nvr_device = {
     .available     = NULL,
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = nvr_at_savestate
 };
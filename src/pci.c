@@ -29,6 +29,8 @@
 #include <86box/dma.h>
 #include <86box/pci.h>
 #include <86box/keyboard.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/plat_unused.h>
 
 #define PCI_ENABLED               0x80000000
@@ -986,3 +988,33 @@ pci_init(int flags)
 
     pic_set_pci_flag(1);
 }
+
+void
+pci_savestate(savestate_t *st)
+{
+    /* The mechanism is part of the machine, only the switchable part is saved. */
+    int     flags = pci_flags & (FLAG_CONFIG_IO_ON | FLAG_CONFIG_M1_IO_ON);
+    uint8_t pmc   = pci_pmc;
+
+    savestate_var(st, flags);
+    savestate_var(st, pmc);
+    savestate_var(st, pci_index);
+    savestate_var(st, pci_func);
+    savestate_var(st, pci_card);
+    savestate_var(st, pci_bus);
+    savestate_var(st, pci_key);
+    savestate_var(st, pci_trc_reg);
+    savestate_var(st, pci_enable);
+    savestate_var(st, pci_irqs);
+    savestate_var(st, pci_irq_level);
+    savestate_var(st, pci_irq_hold);
+    savestate_var(st, pci_mirqs);
+
+    if (st->saving || st->error)
+        return;
+
+    if (pci_flags & FLAG_MECHANISM_SWITCH)
+        pci_set_pmc(pmc);
+
+    pci_flags = (pci_flags & ~(FLAG_CONFIG_IO_ON | FLAG_CONFIG_M1_IO_ON)) | flags;
+}
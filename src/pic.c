@@ -17,6 +17,7 @@
  */
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,6 +37,7 @@
 #include <86box/apm.h>
 #include <86box/nvr.h>
 #include <86box/acpi.h>
+#include <86box/savestate.h>
 #include <86box/plat_unused.h>
 
 enum {
@@ -680,6 +682,21 @@ pic2_init(void)
     pic.slaves[2] = &pic2;
 }
 
+void
+pic_savestate(savestate_t *st)
+{
+    /* The slave pointers are set up by the machine and are not saved. */
+    savestate_rw(st, &pic, offsetof(pic_t, slaves));
+    savestate_rw(st, &pic2, offsetof(pic_t, slaves));
+    savestate_var(st, smi_irq_mask);
+    savestate_var(st, smi_irq_status);
+    savestate_var(st, latched_irqs);
+    savestate_timer(st, &pic_timer);
+
+    if (!st->saving && !st->error && (update_pending != NULL))
+        update_pending();
+}
+
 void
 picint_common(uint16_t num, int level, int set, uint8_t *irq_state)
 {
@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -34,6 +35,7 @@
 #include <86box/timer.h>
 #include <86box/pit.h>
 #include <86box/pit_fast.h>
+#include <86box/savestate.h>
 #include <86box/ppi.h>
 #include <86box/machine.h>
 #include <86box/sound.h>
@@ -922,6 +924,18 @@ pit_speed_changed(void *priv)
     pit_set_pit_const(priv, PITCONST);
 }
 
+static void
+pit_savestate(void *priv, savestate_t *st)
+{
+    pit_t *dev = (pit_t *) priv;
+
+    for (uint8_t i = 0; i < NUM_COUNTERS; i++)
+        savestate_rw(st, &dev->counters[i], offsetof(ctr_t, load_func));
+
+    savestate_var(st, dev->ctrl);
+    savestate_timer(st, &dev->callback_timer);
+}
+
 static void
 pit_close(void *priv)
 {
@@ -973,7 +987,8 @@ const device_t i8253_device = {
     .available     = NULL,
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pit_savestate
 };
 
 const device_t i8253_ext_io_device = {
@@ -987,7 +1002,8 @@ const device_t i8253_ext_io_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pit_savestate
 };
 
 const device_t i8254_device = {
@@ -1001,7 +1017,8 @@ const device_t i8254_device = {
     .available     = NULL,
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pit_savestate
 };
 
 const device_t i8254_sec_device = {
@@ -1015,7 +1032,8 @@ const device_t i8254_sec_device = {
     .available     = NULL,
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pit_savestate
 };
 
 const device_t i8254_ext_io_device = {
@@ -1029,7 +1047,8 @@ const device_t i8254_ext_io_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pit_savestate
 };
 
 const device_t i8254_ps2_device = {
@@ -1043,7 +1062,8 @@ const device_t i8254_ps2_device = {
     .available     = NULL,
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pit_savestate
 };
 
 pit_t *
@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -34,6 +35,7 @@
 #include <86box/timer.h>
 #include <86box/pit.h>
 #include <86box/pit_fast.h>
+#include <86box/savestate.h>
 #include <86box/ppi.h>
 #include <86box/machine.h>
 #include <86box/sound.h>
@@ -693,6 +695,19 @@ pitf_speed_changed(void *priv)
     pitf_set_pit_const(priv, PITCONST);
 }
 
+static void
+pitf_savestate(void *priv, savestate_t *st)
+{
+    pitf_t *dev = (pitf_t *) priv;
+
+    for (uint8_t i = 0; i < NUM_COUNTERS; i++) {
+        savestate_rw(st, &dev->counters[i], offsetof(ctrf_t, timer));
+        savestate_timer(st, &dev->counters[i].timer);
+    }
+
+    savestate_var(st, dev->ctrl);
+}
+
 static void
 pitf_close(void *priv)
 {
@@ -752,7 +767,8 @@ const device_t i8253_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pitf_savestate
 };
 
 const device_t i8254_fast_device = {
@@ -766,7 +782,8 @@ const device_t i8254_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pitf_savestate
 };
 
 const device_t i8254_sec_fast_device = {
@@ -780,7 +797,8 @@ const device_t i8254_sec_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pitf_savestate
 };
 
 const device_t i8254_ext_io_fast_device = {
@@ -794,7 +812,8 @@ const device_t i8254_ext_io_fast_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pitf_savestate
 };
 
 const device_t i8254_ps2_fast_device = {
@@ -808,7 +827,8 @@ const device_t i8254_ps2_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = pitf_savestate
 };
 
 const pit_intf_t pit_fast_intf = {
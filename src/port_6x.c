@@ -36,6 +36,7 @@
 #include <86box/port_6x.h>
 #include <86box/plat_unused.h>
 #include <86box/random.h>
+#include <86box/savestate.h>
 
 #define PS2_REFRESH_TIME (16 * TIMER_USEC)
 
@@ -161,6 +162,27 @@ port_6x_refresh(void *priv)
     timer_advance_u64(&dev->refresh_timer, PS2_REFRESH_TIME);
 }
 
+static void
+port_6x_savestate(void *priv, savestate_t *st)
+{
+    port_6x_t *dev = (port_6x_t *) priv;
+
+    savestate_var(st, dev->refresh);
+    savestate_var(st, ppi.pb);
+    savestate_var(st, ppispeakon);
+    if (dev->flags & PORT_6X_EXT_REF)
+        savestate_timer(st, &dev->refresh_timer);
+
+    if (st->saving || st->error)
+        return;
+
+    /* Port B is also the PPI output to the speaker. */
+    speaker_gated  = ppi.pb & 1;
+    speaker_enable = ppi.pb & 2;
+    if (speaker_enable)
+        was_speaker_enable = 1;
+}
+
 static void
 port_6x_close(void *priv)
 {
@@ -213,7 +235,8 @@ const device_t port_6x_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_6x_savestate
 };
 
 const device_t port_6x_xi8088_device = {
@@ -227,7 +250,8 @@ const device_t port_6x_xi8088_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_6x_savestate
 };
 
 const device_t port_6x_ps2_device = {
@@ -241,7 +265,8 @@ const device_t port_6x_ps2_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_6x_savestate
 };
 
 const device_t port_6x_olivetti_device = {
@@ -255,5 +280,6 @@ const device_t port_6x_olivetti_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_6x_savestate
 };
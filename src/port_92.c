@@ -13,6 +13,7 @@
  *
  *          Copyright 2019 Miran Grca.
  */
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -28,6 +29,7 @@
 #include <86box/pit.h>
 #include <86box/port_92.h>
 #include <86box/plat_unused.h>
+#include <86box/savestate.h>
 
 #define PORT_92_INV   1
 #define PORT_92_WORD  2
@@ -188,6 +190,17 @@ port_92_reset(UNUSED(void *priv))
     mem_a20_recalc();
 }
 
+static void
+port_92_savestate(void *priv, savestate_t *st)
+{
+    port_92_t *dev = (port_92_t *) priv;
+
+    /* The register and the features enabled by the chipset. */
+    savestate_rw(st, dev, offsetof(port_92_t, pulse_timer));
+    savestate_timer(st, &dev->pulse_timer);
+    savestate_var(st, cpu_alt_reset);
+}
+
 static void
 port_92_close(void *priv)
 {
@@ -236,7 +249,8 @@ const device_t port_92_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_92_savestate
 };
 
 const device_t port_92_key_device = {
@@ -250,7 +264,8 @@ const device_t port_92_key_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_92_savestate
 };
 
 const device_t port_92_inv_device = {
@@ -264,7 +279,8 @@ const device_t port_92_inv_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_92_savestate
 };
 
 const device_t port_92_word_device = {
@@ -278,7 +294,8 @@ const device_t port_92_word_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_92_savestate
 };
 
 const device_t port_92_pci_device = {
@@ -292,5 +309,6 @@ const device_t port_92_pci_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = port_92_savestate
 };
@@ -0,0 +1,157 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Implementation of the sampling host profiler.
+ *
+ *          The emulation thread only records what it is currently
+ *          doing in prof_cat, a background thread samples it once
+ *          per millisecond and counts the samples per category.
+ *          The result is a flat text report on stop and, in builds
+ *          with minitrace, counter tracks in the Chrome trace.
+ *
+ *
+ *
+ *          Copyright 2026 The 86Box development team
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/plat_unused.h>
+#include <86box/thread.h>
+#include <86box/profiler.h>
+#ifdef MTR_ENABLED
+#    include <minitrace/minitrace.h>
+#endif
+
+#define PROF_PERIOD_MS     1
+/* Samples per point on the trace counter tracks. */
+#define PROF_TRACE_SAMPLES 100
+
+volatile int prof_cat     = PROF_IDLE;
+int          prof_running = 0;
+
+char prof_report_path[1024] = { '\0' };
+
+static const char *prof_names[PROF_MAX] = {
+    "idle", "other", "interpreter", "jit", "memory", "io", "timers", "devices", "render"
+};
+
+static thread_t *prof_thread_h;
+static uint64_t  prof_samples[PROF_MAX];
+static uint32_t  prof_start_ticks;
+
+static void
+prof_thread(UNUSED(void *priv))
+{
+#ifdef MTR_ENABLED
+    uint32_t window[PROF_MAX] = { 0 };
+    uint32_t window_samples   = 0;
+#endif
+    int cat;
+
+    while (prof_running) {
+        plat_delay_ms(PROF_PERIOD_MS);
+
+        cat = prof_cat;
+        if ((cat < 0) || (cat >= PROF_MAX))
+            cat = PROF_OTHER;
+        prof_samples[cat]++;
+
+#ifdef MTR_ENABLED
+        window[cat]++;
+        if (++window_samples == PROF_TRACE_SAMPLES) {
+            for (cat = 0; cat < PROF_MAX; cat++) {
+                MTR_COUNTER("profiler", prof_names[cat], (window[cat] * 100) / window_samples);
+                window[cat] = 0;
+            }
+            window_samples = 0;
+        }
+#endif
+    }
+}
+
+static void
+prof_out(FILE *fp, const char *fmt, ...)
+{
+    char    temp[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(temp, sizeof(temp), fmt, ap);
+    va_end(ap);
+
+    pclog("%s", temp);
+    if (fp != NULL)
+        fputs(temp, fp);
+}
+
+static void
+prof_report(void)
+{
+    uint64_t total = 0;
+    uint64_t busy;
+    uint32_t host_ms = plat_get_ticks() - prof_start_ticks;
+    FILE    *fp      = NULL;
+
+    for (int c = 0; c < PROF_MAX; c++)
+        total += prof_samples[c];
+    busy = total - prof_samples[PROF_IDLE];
+
+    if (prof_report_path[0] != '\0') {
+        fp = plat_fopen(prof_report_path, "w");
+        if (fp == NULL)
+            pclog("PROFILER: Unable to create \"%s\"\n", prof_report_path);
+    }
+
+    prof_out(fp, "Profiler: %" PRIu64 " samples in %u ms\n", total, host_ms);
+    prof_out(fp, "%-12s %12s %8s %8s\n", "category", "samples", "total", "busy");
+    for (int c = 0; c < PROF_MAX; c++) {
+        prof_out(fp, "%-12s %12" PRIu64 " %7.2f%%", prof_names[c], prof_samples[c],
+                 total ? ((100.0 * (double) prof_samples[c]) / (double) total) : 0.0);
+        if (c == PROF_IDLE)
+            prof_out(fp, "\n");
+        else
+            prof_out(fp, " %7.2f%%\n", busy ? ((100.0 * (double) prof_samples[c]) / (double) busy) : 0.0);
+    }
+
+    if (fp != NULL)
+        fclose(fp);
+}
+
+void
+prof_start(void)
+{
+    if (prof_running)
+        return;
+
+    memset(prof_samples, 0x00, sizeof(prof_samples));
+    prof_start_ticks = plat_get_ticks();
+
+    prof_running  = 1;
+    prof_thread_h = thread_create(prof_thread, NULL);
+}
+
+void
+prof_stop(void)
+{
+    if (!prof_running)
+        return;
+
+    prof_running = 0;
+    thread_wait(prof_thread_h);
+    prof_thread_h = NULL;
+
+    prof_report();
+}
@@ -452,6 +452,11 @@ main_thread_fn()
 #endif
             drawits += static_cast<int>(new_time - old_time);
         old_time = new_time;
+
+        /* Batch mode never waits for the host clock. */
+        if (batch_mode)
+            drawits = 1;
+
         if (drawits > 0 && !dopause) {
             /* Yes, so run frames now. */
             do {
@@ -470,6 +475,9 @@ main_thread_fn()
                         break;
                 }
 #endif
+                if (batch_mode && pc_batch_frame())
+                    break;
+
                 /* Every 2 emulated seconds we save the machine status. */
                 if (++frames >= (force_10ms ? 200 : 2000) && nvr_dosave) {
                     qt_nvr_save();
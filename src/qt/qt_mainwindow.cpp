@@ -53,6 +53,7 @@ extern "C" {
 #include <86box/nvr.h>
 #include <86box/acpi.h>
 #include <86box/renderdefs.h>
+#include <86box/profiler.h>
 
 #ifdef USE_VNC
 #    include <86box/vnc.h>
@@ -444,6 +445,7 @@ MainWindow::MainWindow(QWidget *parent)
     ui->actionHide_tool_bar->setChecked(hide_tool_bar);
     ui->actionShow_non_primary_monitors->setChecked(show_second_monitors);
     ui->actionUpdate_status_bar_icons->setChecked(update_icons);
+    ui->actionHost_profiler->setChecked(prof_running);
     ui->actionEnable_Discord_integration->setChecked(enable_discord);
     ui->actionApply_fullscreen_stretch_mode_when_maximized->setChecked(video_fullscreen_scale_maximized);
 
@@ -2206,6 +2208,17 @@ MainWindow::on_actionUpdate_status_bar_icons_triggered()
     status->clearActivity();
 }
 
+/* The report goes to the log, or to the file given with --profile. */
+void
+MainWindow::on_actionHost_profiler_triggered()
+{
+    if (prof_running)
+        prof_stop();
+    else
+        prof_start();
+    ui->actionHost_profiler->setChecked(prof_running);
+}
+
 void
 MainWindow::on_actionTake_screenshot_triggered()
 {
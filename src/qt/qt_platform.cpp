@@ -21,6 +21,7 @@
 #endif
 
 #include <cstdio>
+#include <cinttypes>
 
 #include <mutex>
 #include <thread>
@@ -59,6 +60,8 @@
 #ifdef Q_OS_UNIX
 #    include <pthread.h>
 #    include <sys/mman.h>
+#    include <fcntl.h>
+#    include <unistd.h>
 #endif
 
 #include <sys/stat.h>
@@ -212,6 +215,12 @@ plat_timer_read(void)
     return elapsed_timer.elapsed();
 }
 
+uint64_t
+plat_get_us(void)
+{
+    return elapsed_timer.nsecsElapsed() / 1000;
+}
+
 FILE *
 plat_fopen(const char *path, const char *mode)
 {
@@ -449,6 +458,93 @@ plat_munmap(void *ptr, size_t size)
 #endif
 }
 
+void *
+plat_mmap_file(const char *path, size_t size)
+{
+#if defined Q_OS_UNIX
+    struct stat st;
+    size_t      page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t      len;
+    void       *ret;
+    int         fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    /* Reserve the whole block as anonymous memory first, so that any part not
+       covered by the file is zero-filled rather than raising SIGBUS. */
+    ret = mmap(0, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (ret == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    len = ((size_t) st.st_size < size) ? (size_t) st.st_size : size;
+    len = (len + page - 1) & ~(page - 1);
+    if (len && (mmap(ret, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+        munmap(ret, size);
+        ret = nullptr;
+    }
+
+    close(fd);
+    return ret;
+#else
+    /* Not supported, plat_munmap() could not release such a mapping anyway. */
+    (void) path;
+    (void) size;
+    return nullptr;
+#endif
+}
+
+int
+plat_mmap_stats(void *ptr, size_t size, uint64_t *shared, uint64_t *priv)
+{
+#if defined Q_OS_LINUX
+    uintptr_t start = (uintptr_t) ptr;
+    uintptr_t end   = start + size;
+    uintptr_t lo;
+    uintptr_t hi;
+    uint64_t  rss  = 0;
+    uint64_t  anon = 0;
+    uint64_t  val;
+    int       in   = 0;
+    char      line[512];
+    FILE     *fp;
+
+    fp = fopen("/proc/self/smaps", "r");
+    if (fp == nullptr)
+        return -1;
+
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &lo, &hi) == 2)
+            in = (lo < end) && (hi > start);
+        else if (in && (sscanf(line, "Rss: %" SCNu64, &val) == 1))
+            rss += val;
+        else if (in && (sscanf(line, "Anonymous: %" SCNu64, &val) == 1))
+            anon += val;
+    }
+
+    fclose(fp);
+
+    /* Resident pages still backed by the file are shared with every other
+       mapping of it, anonymous ones have been copied on write. */
+    *shared = ((rss - anon) * 1024) / (uint64_t) sysconf(_SC_PAGESIZE);
+    *priv   = (anon * 1024) / (uint64_t) sysconf(_SC_PAGESIZE);
+    return 0;
+#else
+    (void) ptr;
+    (void) size;
+    *shared = *priv = 0;
+    return -1;
+#endif
+}
+
 extern bool cpu_thread_running;
 
 #ifdef Q_OS_WINDOWS
@@ -0,0 +1,298 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Implementation of whole-machine save states.
+ *
+ *          A state file is only valid for the exact configuration it
+ *          was taken with: the machine, CPU, memory size and the list
+ *          of attached devices are recorded in the header and checked
+ *          on load. The machine is first built normally through the
+ *          hard reset path, then every module overwrites its state
+ *          from the file, which skips the entire POST and boot.
+ *
+ *          Every attached device must implement the device_t
+ *          savestate hook, otherwise saving is refused. The hooks
+ *          currently cover two reference configurations:
+ *
+ *          - the IBM PC (5150) with its stock devices: the CGA, the
+ *            PC keyboard, the XT floppy controller, the cassette and
+ *            the serial and parallel ports;
+ *          - the YAMAHA YM430TX (i430TX, PIIX4, W83977TF) with the
+ *            IBM VGA, an IDE hard disk on the internal controller
+ *            and no mouse, sound or network card: the chipset, the
+ *            PIIX4 functions with their ACPI, APM, SMBus, USB and
+ *            bus master IDE parts, the AT keyboard controller with
+ *            the PS/2 keyboard, the Super I/O and the flash.
+ *
+ *          A device also refuses the save while it is in the middle
+ *          of an operation or has something attached that can not be
+ *          saved. Disk images are not part of the state and must be
+ *          left untouched between saving and restoring.
+ *
+ *
+ *
+ *          Copyright 2025 The 86Box development team
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/device.h>
+#include <86box/fifo.h>
+#include <86box/machine.h>
+#include <86box/mem.h>
+#include <86box/plat.h>
+#include <86box/timer.h>
+#include <86box/ui.h>
+#include <86box/savestate.h>
+
+#define SAVESTATE_MAGIC "86BxSTAT"
+
+char savestate_load_path[1024] = { '\0' };
+char savestate_save_path[1024] = { '\0' };
+
+typedef struct savestate_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t mem_size;
+    char     machine[SAVESTATE_NAME_LEN];
+    char     cpu_family[SAVESTATE_NAME_LEN];
+    int32_t  cpu;
+    int32_t  fpu_type;
+} savestate_header_t;
+
+#ifdef ENABLE_SAVESTATE_LOG
+int savestate_do_log = ENABLE_SAVESTATE_LOG;
+
+static void
+savestate_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (savestate_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define savestate_log(fmt, ...)
+#endif
+
+void
+savestate_rw(savestate_t *st, void *data, size_t size)
+{
+    size_t ret;
+
+    if (st->error)
+        return;
+
+    if (st->saving)
+        ret = fwrite(data, 1, size, st->fp);
+    else
+        ret = fread(data, 1, size, st->fp);
+
+    if (ret != size)
+        st->error = 1;
+}
+
+void
+savestate_section(savestate_t *st, const char *tag)
+{
+    char buf[8] = { 0 };
+    char exp[8] = { 0 };
+
+    memcpy(exp, tag, MIN(strlen(tag), sizeof(exp)));
+
+    if (st->saving)
+        savestate_rw(st, exp, sizeof(exp));
+    else {
+        savestate_rw(st, buf, sizeof(buf));
+        if (!st->error && memcmp(buf, exp, sizeof(buf))) {
+            pclog("SAVESTATE: Expected section \"%.8s\", found \"%.8s\"\n", exp, buf);
+            st->error = 1;
+        }
+    }
+}
+
+void
+savestate_timer(savestate_t *st, pc_timer_t *timer)
+{
+    uint64_t ts      = timer->ts.ts64;
+    double   period  = timer->period;
+    uint8_t  enabled = !!(timer->flags & TIMER_ENABLED);
+    uint8_t  split   = !!(timer->flags & TIMER_SPLIT);
+
+    savestate_var(st, ts);
+    savestate_var(st, period);
+    savestate_var(st, enabled);
+    savestate_var(st, split);
+
+    if (st->saving || st->error)
+        return;
+
+    /* The TSC has already been restored at this point. */
+    timer_disable(timer);
+    timer->ts.ts64 = ts;
+    timer->period  = period;
+    if (split)
+        timer->flags |= TIMER_SPLIT;
+    else
+        timer->flags &= ~TIMER_SPLIT;
+    if (enabled)
+        timer_enable(timer);
+}
+
+void
+savestate_fifo(savestate_t *st, void *fifo, int size)
+{
+    fifo_t *f = (fifo_t *) fifo;
+
+    /* The counters and flags come first, the tags and data last. */
+    savestate_rw(st, f, offsetof(fifo_t, priv));
+    savestate_rw(st, f->tag, sizeof(f->tag) + size);
+}
+
+void
+savestate_refuse(savestate_t *st, const char *dev, const char *reason)
+{
+    if (!st->error)
+        pclog("SAVESTATE: Device \"%s\" can not be saved while %s\n", dev, reason);
+    st->error = 1;
+}
+
+static void
+savestate_header(savestate_t *st)
+{
+    savestate_header_t hdr;
+    savestate_header_t cur;
+
+    memset(&cur, 0x00, sizeof(savestate_header_t));
+    memcpy(cur.magic, SAVESTATE_MAGIC, sizeof(cur.magic));
+    cur.version  = SAVESTATE_VERSION;
+    cur.mem_size = mem_size;
+    strncpy(cur.machine, machine_get_internal_name(), SAVESTATE_NAME_LEN - 1);
+    strncpy(cur.cpu_family, cpu_f->internal_name, SAVESTATE_NAME_LEN - 1);
+    cur.cpu      = cpu;
+    cur.fpu_type = fpu_type;
+
+    if (st->saving) {
+        savestate_var(st, cur);
+        return;
+    }
+
+    savestate_var(st, hdr);
+    if (st->error)
+        return;
+
+    if (memcmp(hdr.magic, cur.magic, sizeof(hdr.magic))) {
+        pclog("SAVESTATE: Not a save state file\n");
+        st->error = 1;
+    } else if (hdr.version != cur.version) {
+        pclog("SAVESTATE: Unsupported version %u (expected %u)\n", hdr.version, cur.version);
+        st->error = 1;
+    } else if (memcmp(&hdr, &cur, sizeof(savestate_header_t))) {
+        pclog("SAVESTATE: State was saved with a different configuration "
+              "(%s, %s #%i, %u KB)\n", hdr.machine, hdr.cpu_family, hdr.cpu, hdr.mem_size);
+        st->error = 1;
+    }
+}
+
+static int
+savestate_process(savestate_t *st)
+{
+    savestate_header(st);
+
+    savestate_section(st, "CPU");
+    cpu_savestate(st);
+
+    savestate_section(st, "MEM");
+    mem_savestate(st);
+
+    savestate_section(st, "DMA");
+    dma_savestate(st);
+
+    savestate_section(st, "PCI");
+    pci_savestate(st);
+
+    savestate_section(st, "DEVICES");
+    device_savestate_all(st);
+
+    /* Last, so that the IRQ lines the devices replay on load do not clobber it. */
+    savestate_section(st, "PIC");
+    pic_savestate(st);
+
+    savestate_section(st, "END");
+
+    return st->error ? -1 : 0;
+}
+
+int
+savestate_save(const char *fn)
+{
+    savestate_t st = { 0 };
+    const char *dev;
+    int         ret;
+
+    dev = device_savestate_unsupported();
+    if (dev != NULL) {
+        pclog("SAVESTATE: Device \"%s\" does not support save states, not saving\n", dev);
+        return -1;
+    }
+
+    st.fp = plat_fopen(fn, "wb");
+    if (st.fp == NULL) {
+        pclog("SAVESTATE: Unable to create \"%s\"\n", fn);
+        return -1;
+    }
+    st.saving = 1;
+
+    ret = savestate_process(&st);
+    fclose(st.fp);
+
+    if (ret)
+        pclog("SAVESTATE: Error writing \"%s\"\n", fn);
+    else {
+        savestate_log("SAVESTATE: Saved state to \"%s\"\n", fn);
+    }
+
+    return ret;
+}
+
+int
+savestate_load(const char *fn)
+{
+    savestate_t st = { 0 };
+    int         ret;
+
+    st.fp = plat_fopen(fn, "rb");
+    if (st.fp == NULL) {
+        pclog("SAVESTATE: Unable to open \"%s\"\n", fn);
+        return -1;
+    }
+    st.saving = 0;
+
+    ret = savestate_process(&st);
+    fclose(st.fp);
+
+    if (ret) {
+        /* A partially restored machine is unusable, start over. */
+        pclog("SAVESTATE: Error restoring \"%s\", resetting the machine\n", fn);
+        pc_reset_hard();
+    } else {
+        savestate_log("SAVESTATE: Restored state from \"%s\"\n", fn);
+    }
+
+    return ret;
+}
@@ -13,6 +13,7 @@
  *          Copyright 2025 Miran Grca.
  */
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,6 +39,7 @@
 #include <86box/plat_unused.h>
 #include <86box/video.h>
 #include <86box/sio.h>
+#include <86box/savestate.h>
 #include "cpu.h"
 
 typedef struct w83977_gpio_t {
@@ -1251,6 +1253,42 @@ w83977_reset(void *priv)
     dev->locked = 0;
 }
 
+static void
+w83977_savestate(void *priv, savestate_t *st)
+{
+    w83977_t *dev = (w83977_t *) priv;
+
+    /* The registers; the bases still describe the current mappings. */
+    savestate_rw(st, dev, offsetof(w83977_t, kbc_type));
+    savestate_var(st, dev->locked);
+    savestate_var(st, dev->cur_reg);
+    for (int i = 0; i < 3; i++)
+        savestate_rw(st, &dev->gpio[i], offsetof(w83977_gpio_t, base));
+
+    if (st->saving || st->error)
+        return;
+
+    /* Move everything over to the restored configuration. */
+    w83977_lpt_handler(dev);
+    w83977_serial_handler(dev, 0);
+    w83977_serial_handler(dev, 1);
+
+    if (dev->id != 1) {
+        w83977_fdc_handler(dev);
+
+        if ((dev->type == W83977F) && dev->has_nvr)
+            w83977_nvr_handler(dev);
+
+        w83977_kbc_handler(dev);
+        fdc_3f1_enable(dev->fdc, !dev->locked);
+    }
+
+    w83977_superio_handler(dev);
+
+    for (int i = 0; i < 3; i++)
+        w83977_gpio_handler(dev, i);
+}
+
 static void
 w83977_close(void *priv)
 {
@@ -1340,5 +1378,6 @@ const device_t w83977_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = w83977_savestate
 };
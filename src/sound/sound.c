@@ -277,6 +277,17 @@ sound_cd_clean_buffers(void)
         memset(cd_out_buffer_int16, 0, (CD_BUFLEN * 2) * sizeof(int16_t));
 }
 
+/* In batch mode the emulation runs faster than real time, there is nothing
+   sensible to hand to the host audio device then. */
+static void
+sound_give_buffer(void (*give)(const void *buf), const void *buf_float, const void *buf_int16)
+{
+    if (batch_mode)
+        return;
+
+    give(sound_is_float ? buf_float : buf_int16);
+}
+
 static void
 sound_cd_thread(UNUSED(void *param))
 {
@@ -387,10 +398,7 @@ sound_cd_thread(UNUSED(void *param))
             }
         }
 
-        if (sound_is_float)
-            givealbuffer_cd(cd_out_buffer);
-        else
-            givealbuffer_cd(cd_out_buffer_int16);
+        sound_give_buffer(givealbuffer_cd, cd_out_buffer, cd_out_buffer_int16);
     }
 }
 
@@ -593,10 +601,7 @@ sound_poll(UNUSED(void *priv))
             }
         }
 
-        if (sound_is_float)
-            givealbuffer(outbuffer_ex);
-        else
-            givealbuffer(outbuffer_ex_int16);
+        sound_give_buffer(givealbuffer, outbuffer_ex, outbuffer_ex_int16);
 
         if (cd_thread_enable) {
             cd_buf_update--;
@@ -640,10 +645,7 @@ music_poll(UNUSED(void *priv))
             }
         }
 
-        if (sound_is_float)
-            givealbuffer_music(outbuffer_m_ex);
-        else
-            givealbuffer_music(outbuffer_m_ex_int16);
+        sound_give_buffer(givealbuffer_music, outbuffer_m_ex, outbuffer_m_ex_int16);
 
         music_pos_global = 0;
     }
@@ -676,10 +678,7 @@ wavetable_poll(UNUSED(void *priv))
             }
         }
 
-        if (sound_is_float)
-            givealbuffer_wt(outbuffer_w_ex);
-        else
-            givealbuffer_wt(outbuffer_w_ex_int16);
+        sound_give_buffer(givealbuffer_wt, outbuffer_w_ex, outbuffer_w_ex_int16);
 
         wavetable_pos_global = 0;
     }
@@ -809,7 +808,8 @@ sound_fdd_thread(UNUSED(void *param))
         static float fdd_float_buffer[SOUNDBUFLEN * 2];
         memset(fdd_float_buffer, 0, sizeof(fdd_float_buffer));
         fdd_audio_callback((int16_t*)fdd_float_buffer, SOUNDBUFLEN * 2);
-        givealbuffer_fdd(fdd_float_buffer, SOUNDBUFLEN * 2);
+        if (!batch_mode)
+            givealbuffer_fdd(fdd_float_buffer, SOUNDBUFLEN * 2);
     }
 }
 
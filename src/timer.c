@@ -1,29 +1,146 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/timer.h>
+#include <86box/profiler.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 
 uint64_t TIMER_USEC;
 uint32_t timer_target;
 
-/*Enabled timers are stored in a linked list, with the first timer to expire at
-  the head.*/
-pc_timer_t *timer_head = NULL;
+/*Enabled timers are stored in a 4-ary min-heap keyed on the 32:32 timestamp,
+  with the first timer to expire at the root. Timers with equal timestamps
+  expire in reverse order of enabling, same as the old sorted list did.*/
+#define TIMER_HEAP_ARITY 4
+
+/*Heap entries carry a copy of the sort key, so that sifting does not have to
+  chase the timer pointers.*/
+typedef struct timer_heap_entry_t {
+    uint64_t    ts;
+    uint32_t    seq;
+    pc_timer_t *timer;
+} timer_heap_entry_t;
+
+static timer_heap_entry_t *timer_heap      = NULL;
+static uint32_t            timer_heap_size = 0;
+static uint32_t            timer_heap_max  = 0;
+static uint32_t            timer_seq       = 0;
 
 /* Are we initialized? */
 int timer_inited = 0;
 
 static void timer_advance_ex(pc_timer_t *timer, int start);
 
+/*True if entry a has to be processed before entry b*/
+static __inline int
+timer_heap_before(const timer_heap_entry_t *a, const timer_heap_entry_t *b)
+{
+    int64_t diff = (int64_t) (a->ts - b->ts);
+
+    if (diff != 0)
+        return (diff < 0);
+
+    return ((int32_t) (a->seq - b->seq) > 0);
+}
+
+static __inline void
+timer_heap_set(uint32_t pos, const timer_heap_entry_t *entry)
+{
+    timer_heap[pos]        = *entry;
+    entry->timer->heap_pos = pos + 1;
+}
+
+static void
+timer_heap_sift_up(uint32_t pos)
+{
+    timer_heap_entry_t entry = timer_heap[pos];
+    uint32_t           parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / TIMER_HEAP_ARITY;
+
+        if (!timer_heap_before(&entry, &timer_heap[parent]))
+            break;
+
+        timer_heap_set(pos, &timer_heap[parent]);
+        pos = parent;
+    }
+
+    timer_heap_set(pos, &entry);
+}
+
+static void
+timer_heap_sift_down(uint32_t pos)
+{
+    timer_heap_entry_t entry = timer_heap[pos];
+    uint32_t           child;
+    uint32_t           last;
+    uint32_t           best;
+
+    while (1) {
+        child = (pos * TIMER_HEAP_ARITY) + 1;
+        if (child >= timer_heap_size)
+            break;
+
+        last = child + TIMER_HEAP_ARITY;
+        if (last > timer_heap_size)
+            last = timer_heap_size;
+
+        best = child;
+        for (child++; child < last; child++) {
+            if (timer_heap_before(&timer_heap[child], &timer_heap[best]))
+                best = child;
+        }
+
+        if (!timer_heap_before(&timer_heap[best], &entry))
+            break;
+
+        timer_heap_set(pos, &timer_heap[best]);
+        pos = best;
+    }
+
+    timer_heap_set(pos, &entry);
+}
+
+/*Restore the heap order after the key at pos has changed*/
+static void
+timer_heap_fix(uint32_t pos)
+{
+    if ((pos > 0) && timer_heap_before(&timer_heap[pos], &timer_heap[(pos - 1) / TIMER_HEAP_ARITY]))
+        timer_heap_sift_up(pos);
+    else
+        timer_heap_sift_down(pos);
+}
+
+static void
+timer_heap_remove(pc_timer_t *timer)
+{
+    uint32_t pos = timer->heap_pos - 1;
+
+    timer->heap_pos = 0;
+
+    if (pos == --timer_heap_size)
+        return;
+
+    timer_heap_set(pos, &timer_heap[timer_heap_size]);
+    timer_heap_fix(pos);
+}
+
+static __inline void
+timer_update_target(void)
+{
+    if (timer_heap_size)
+        timer_target = (uint32_t) (timer_heap[0].ts >> 32);
+}
+
 void
 timer_enable(pc_timer_t *timer)
 {
-    pc_timer_t *timer_node = timer_head;
-    int ret = 0;
+    uint32_t pos;
 
     if (!timer_inited || (timer == NULL))
         return;
@@ -31,60 +148,26 @@ timer_enable(pc_timer_t *timer)
     if (timer->flags & TIMER_ENABLED)
         timer_disable(timer);
 
-    if (timer->next || timer->prev)
-        fatal("timer_disable(): Attempting to enable a non-isolated "
+    if (timer->heap_pos)
+        fatal("timer_enable(): Attempting to enable a queued "
               "timer incorrectly marked as disabled\n");
 
-    /*List currently empty - add to head*/
-    if (!timer_head) {
-        timer_head  = timer;
-        timer->next = timer->prev = NULL;
-        timer_target              = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (TIMER_LESS_THAN(timer, timer_head)) {
-        timer->next      = timer_head;
-        timer->prev      = NULL;
-        timer_head->prev = timer;
-        timer_head       = timer;
-        timer_target     = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (!timer_head->next) {
-        timer_head->next = timer;
-        timer->prev      = timer_head;
-        ret = 1;
+    if (timer_heap_size == timer_heap_max) {
+        timer_heap_max = timer_heap_max ? (timer_heap_max << 1) : 64;
+        timer_heap     = (timer_heap_entry_t *) realloc(timer_heap, timer_heap_max * sizeof(timer_heap_entry_t));
+        if (timer_heap == NULL)
+            fatal("timer_enable(): Unable to grow the timer heap to %u entries\n", timer_heap_max);
     }
 
-    if (ret == 0) {
-        pc_timer_t *prev = timer_head;
-        timer_node       = timer_head->next;
-
-        while (1) {
-            /*Timer expires before timer_node. Add to list in front of timer_node*/
-            if (TIMER_LESS_THAN(timer, timer_node)) {
-                timer->next      = timer_node;
-                timer->prev      = prev;
-                timer_node->prev = timer;
-                prev->next       = timer;
-                ret = 1;
-                break;
-            }
-
-            /*timer_node is last in the list. Add timer to end of list*/
-            if (!timer_node->next) {
-                timer_node->next = timer;
-                timer->prev      = timer_node;
-                ret = 1;
-                break;
-            }
-
-            prev       = timer_node;
-            timer_node = timer_node->next;
-        }
-    }
+    pos                   = timer_heap_size++;
+    timer_heap[pos].timer = timer;
+    timer_heap[pos].ts    = timer->ts.ts64;
+    timer_heap[pos].seq   = timer_seq++;
+    timer->heap_pos       = pos + 1;
+    timer_heap_sift_up(pos);
+    timer_update_target();
 
-    /* Do not mark it as enabled if it has failed every single condition. */
-    if (ret == 1)
-        timer->flags |= TIMER_ENABLED;
+    timer->flags |= TIMER_ENABLED;
 }
 
 void
@@ -93,42 +176,38 @@ timer_disable(pc_timer_t *timer)
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
         return;
 
-    if (!timer->next && !timer->prev && timer != timer_head)
-        fatal("timer_disable(): Attempting to disable an isolated "
-              "non-head timer incorrectly marked as enabled\n");
+    if (!timer->heap_pos || (timer->heap_pos > timer_heap_size) || (timer_heap[timer->heap_pos - 1].timer != timer))
+        fatal("timer_disable(): Attempting to disable a non-queued "
+              "timer incorrectly marked as enabled\n");
 
     timer->flags &= ~TIMER_ENABLED;
     timer->in_callback = 0;
 
-    if (timer->prev)
-        timer->prev->next = timer->next;
-    else
-        timer_head = timer->next;
-    if (timer->next)
-        timer->next->prev = timer->prev;
-    timer->prev = timer->next = NULL;
+    timer_heap_remove(timer);
+    timer_update_target();
 }
 
 void
 timer_process(void)
 {
     pc_timer_t *timer;
+    int         prof_old;
 
-    if (!timer_head)
+    if (!timer_heap_size)
         return;
 
-    while (1) {
-        timer = timer_head;
+    prof_old = prof_enter(PROF_TIMER);
 
-        if (!TIMER_LESS_THAN_VAL(timer, (uint32_t) tsc))
+    while (timer_heap_size) {
+        if (!TIMER_VAL_LESS_THAN_VAL((uint32_t) (timer_heap[0].ts >> 32), (uint32_t) tsc))
             break;
 
-        timer_head = timer->next;
-        if (timer_head)
-            timer_head->prev = NULL;
+        timer = timer_heap[0].timer;
 
-        timer->next = timer->prev = NULL;
+        /* Unlink it before the callback, which may re-arm the timer, stop it
+           or free the structure it lives in. */
         timer->flags &= ~TIMER_ENABLED;
+        timer_heap_remove(timer);
 
         if (timer->flags & TIMER_SPLIT)
             timer_advance_ex(timer, 0);   /* We're splitting a > 1 s period into
@@ -138,30 +217,28 @@ timer_process(void)
                have a NULL callback when no operation
                is needed. */
             timer->in_callback = 1;
+            prof_cat           = PROF_DEVICE;
             timer->callback(timer->priv);
+            prof_cat           = PROF_TIMER;
             timer->in_callback = 0;
         }
     }
 
-    timer_target = timer_head->ts.ts32.integer;
+    timer_update_target();
+
+    prof_leave(prof_old);
 }
 
 void
 timer_close(void)
 {
-    pc_timer_t *t = timer_head;
-    pc_timer_t *r;
-
-    /* Set all timers' prev and next to NULL so it is assured that
-       timers that are not in malloc'd structs don't keep pointing
-       to timers that may be in malloc'd structs. */
-    while (t != NULL) {
-        r       = t;
-        r->prev = r->next = NULL;
-        t                 = r->next;
-    }
+    /* Mark all queued timers as no longer queued so it is assured that
+       timers that are not in malloc'd structs don't keep referring
+       to heap slots that are about to go away. */
+    for (uint32_t i = 0; i < timer_heap_size; i++)
+        timer_heap[i].timer->heap_pos = 0;
 
-    timer_head = NULL;
+    timer_heap_size = 0;
 
     timer_inited = 0;
 }
@@ -187,7 +264,7 @@ timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start
     timer->in_callback = 0;
     timer->priv        = priv;
     timer->flags       = 0;
-    timer->prev        = timer->next = NULL;
+    timer->heap_pos    = 0;
     if (start_timer)
         timer_set_delay_u64(timer, 0);
 }
@@ -264,26 +341,26 @@ timer_on_auto(pc_timer_t *timer, double period)
 void
 timer_set_new_tsc(uint64_t new_tsc)
 {
-    pc_timer_t *timer = NULL;
+    pc_timer_t *timer;
     /* Run timers already expired. */
 #ifdef USE_DYNAREC
     if (cpu_use_dynarec)
         update_tsc();
 #endif
 
-    if (!timer_head) {
+    if (!timer_heap_size) {
         tsc = new_tsc;
         return;
     }
 
-    timer = timer_head;
-    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_head) - (uint32_t)tsc);
+    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_heap[0].timer) - (uint32_t)tsc);
 
-    while (timer) {
+    /* Every timer is shifted by the same amount, so the heap order holds. */
+    for (uint32_t i = 0; i < timer_heap_size; i++) {
+        timer = timer_heap[i].timer;
         int32_t offset_from_current_tsc = (int32_t)(timer_get_ts_int(timer) - (uint32_t)tsc);
         timer->ts.ts32.integer = new_tsc + offset_from_current_tsc;
-
-        timer = timer->next;
+        timer_heap[i].ts       = timer->ts.ts64;
     }
 
     tsc = new_tsc;
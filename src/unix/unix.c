@@ -16,6 +16,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <inttypes.h>
@@ -49,6 +50,7 @@
 #include <86box/video.h>
 #include <86box/ui.h>
 #include <86box/gdbstub.h>
+#include <86box/profiler.h>
 
 #define __USE_GNU 1 /* shouldn't be done, yet it is */
 #include <pthread.h>
@@ -452,6 +454,86 @@ plat_munmap(void *ptr, size_t size)
     munmap(ptr, size);
 }
 
+void *
+plat_mmap_file(const char *path, size_t size)
+{
+    struct stat st;
+    size_t      page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t      len;
+    void       *ret;
+    int         fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    /* Reserve the whole block as anonymous memory first, so that any part not
+       covered by the file is zero-filled rather than raising SIGBUS. */
+    ret = mmap(0, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (ret == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    len = ((size_t) st.st_size < size) ? (size_t) st.st_size : size;
+    len = (len + page - 1) & ~(page - 1);
+    if (len && (mmap(ret, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+        munmap(ret, size);
+        ret = NULL;
+    }
+
+    close(fd);
+    return ret;
+}
+
+int
+plat_mmap_stats(void *ptr, size_t size, uint64_t *shared, uint64_t *priv)
+{
+#ifdef __linux__
+    uintptr_t start = (uintptr_t) ptr;
+    uintptr_t end   = start + size;
+    uintptr_t lo;
+    uintptr_t hi;
+    uint64_t  rss  = 0;
+    uint64_t  anon = 0;
+    uint64_t  val;
+    int       in   = 0;
+    char      line[512];
+    FILE     *fp;
+
+    fp = fopen("/proc/self/smaps", "r");
+    if (fp == NULL)
+        return -1;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &lo, &hi) == 2)
+            in = (lo < end) && (hi > start);
+        else if (in && (sscanf(line, "Rss: %" SCNu64, &val) == 1))
+            rss += val;
+        else if (in && (sscanf(line, "Anonymous: %" SCNu64, &val) == 1))
+            anon += val;
+    }
+
+    fclose(fp);
+
+    /* Resident pages still backed by the file are shared with every other
+       mapping of it, anonymous ones have been copied on write. */
+    *shared = ((rss - anon) * 1024) / (uint64_t) sysconf(_SC_PAGESIZE);
+    *priv   = (anon * 1024) / (uint64_t) sysconf(_SC_PAGESIZE);
+    return 0;
+#else
+    (void) ptr;
+    (void) size;
+    *shared = *priv = 0;
+    return -1;
+#endif
+}
+
 uint64_t
 plat_timer_read(void)
 {
@@ -481,6 +563,12 @@ plat_get_ticks(void)
     return (uint32_t) (plat_get_ticks_common() / 1000);
 }
 
+uint64_t
+plat_get_us(void)
+{
+    return plat_get_ticks_common();
+}
+
 void
 plat_remove(char *path)
 {
@@ -599,6 +687,11 @@ main_thread(UNUSED(void *param))
 #endif
 
         old_time = new_time;
+
+        /* Batch mode never waits for the host clock. */
+        if (batch_mode)
+            drawits = 1;
+
         if (drawits > 0 && !dopause) {
             /* Yes, so do one frame now. */
             drawits -= force_10ms ? 10 : 1;
@@ -608,6 +701,9 @@ main_thread(UNUSED(void *param))
             /* Run a block of code. */
             pc_run();
 
+            if (batch_mode && pc_batch_frame())
+                break;
+
             /* Every 200 frames we save the machine status. */
             if (++frames >= (force_10ms ? 200 : 2000) && nvr_dosave) {
                 nvr_save();
@@ -1032,6 +1128,7 @@ unix_executeLine(char *line)
                 "hardreset - hard reset the emulated system.\n"
                 "pause - pause the the emulated system.\n"
                 "fullscreen - toggle fullscreen.\n"
+                "profile - start or stop the host profiler.\n"
                 "version - print version and license information.\n"
                 "exit - exit 86Box.\n");
         } else if (strncasecmp(xargv[0], "exit", 4) == 0) {
@@ -1074,6 +1171,13 @@ unix_executeLine(char *line)
         } else if (strncasecmp(xargv[0], "pause", 5) == 0) {
             plat_pause(dopause ^ 1);
             printf("%s", dopause ? "Paused.\n" : "Unpaused.\n");
+        } else if (strncasecmp(xargv[0], "profile", 7) == 0) {
+            /* The report goes to the log, or to the file given with --profile. */
+            if (prof_running)
+                prof_stop();
+            else
+                prof_start();
+            printf("%s", prof_running ? "Profiler started.\n" : "Profiler stopped.\n");
         } else if (strncasecmp(xargv[0], "hardreset", 9) == 0) {
             pc_reset_hard();
         } else if (strncasecmp(xargv[0], "cdload", 6) == 0 && cmdargc >= 3) {
@@ -25,6 +25,8 @@
 #include <86box/io.h>
 #include <86box/mem.h>
 #include <86box/usb.h>
+#include <86box/timer.h>
+#include <86box/savestate.h>
 #include "cpu.h"
 #include <86box/plat_unused.h>
 
@@ -387,6 +389,16 @@ usb_reset(void *priv)
     dev->ohci_enable = 0;
 }
 
+static void
+usb_savestate(void *priv, savestate_t *st)
+{
+    usb_t *dev = (usb_t *) priv;
+
+    /* The I/O and memory mappings are programmed, and restored, by the southbridge. */
+    savestate_var(st, dev->uhci_io);
+    savestate_var(st, dev->ohci_mmio);
+}
+
 static void
 usb_close(void *priv)
 {
@@ -434,5 +446,6 @@ const device_t usb_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = usb_savestate
 };
@@ -17,6 +17,7 @@
  *          Copyright 2023      W. M. Martinez
  */
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
@@ -34,6 +35,7 @@
 #include <86box/vid_cga.h>
 #include <86box/vid_cga_comp.h>
 #include <86box/plat_unused.h>
+#include <86box/savestate.h>
 
 #define CGA_RGB       0
 #define CGA_COMPOSITE 1
@@ -928,6 +930,36 @@ const device_config_t cga_config[] = {
 };
 // clang-format on
 
+static void
+cga_savestate(void *priv, savestate_t *st)
+{
+    cga_t *cga = (cga_t *) priv;
+
+    savestate_var(st, cga->crtcreg);
+    savestate_var(st, cga->crtc);
+    savestate_var(st, cga->cgastat);
+    savestate_var(st, cga->cgamode);
+    savestate_var(st, cga->cgacol);
+    savestate_var(st, cga->lp_strobe);
+    /* Raster position, fontbase through oddeven. */
+    savestate_rw(st, &cga->fontbase, offsetof(cga_t, dispontime) - offsetof(cga_t, fontbase));
+    savestate_var(st, cga->dispontime);
+    savestate_var(st, cga->dispofftime);
+    savestate_timer(st, &cga->timer);
+    savestate_var(st, cga->firstline);
+    savestate_var(st, cga->lastline);
+    savestate_var(st, cga->drawcursor);
+    savestate_rw(st, cga->vram, DEVICE_VRAM);
+    savestate_var(st, cga->charbuffer);
+
+    if (st->saving || st->error)
+        return;
+
+    update_cga16_color(cga->cgamode);
+    cga_recalctimings(cga);
+    cga->fullchange = changeframecount;
+}
+
 const device_t cga_device = {
     .name          = "IBM CGA",
     .internal_name = "cga",
@@ -939,7 +971,8 @@ const device_t cga_device = {
     .available     = NULL,
     .speed_changed = cga_speed_changed,
     .force_redraw  = NULL,
-    .config        = cga_config
+    .config        = cga_config,
+    .savestate     = cga_savestate
 };
 
 const device_t cga_pravetz_device = {
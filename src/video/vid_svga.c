@@ -19,6 +19,8 @@
  */
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -35,6 +37,9 @@
 #include <86box/mem.h>
 #include <86box/rom.h>
 #include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/profiler.h>
+#include <86box/savestate.h>
 #include <86box/ui.h>
 #include <86box/video.h>
 #include <86box/vid_8514a.h>
@@ -43,8 +48,9 @@
 #include <86box/vid_svga_render.h>
 #include <86box/vid_xga_device.h>
 
-void svga_doblit(int wx, int wy, svga_t *svga);
-void svga_poll(void *priv);
+void        svga_doblit(int wx, int wy, svga_t *svga);
+static void svga_doblit_dirty(int wx, int wy, int first, int last, svga_t *svga);
+void        svga_poll(void *priv);
 
 svga_t *svga_8514;
 
@@ -236,6 +242,8 @@ svga_out(uint16_t addr, uint8_t val, void *priv)
                     svga_recalctimings(svga);
                 }
             } else {
+                /* The renderers read the palette, mode and plane mask bits. */
+                svga->render_gen++;
                 if ((svga->attraddr == 0x13) && (svga->attrregs[0x13] != val))
                     svga->fullchange = svga->monitor->mon_changeframecount;
                 o                                   = svga->attrregs[svga->attraddr & 0x1f];
@@ -318,6 +326,7 @@ svga_out(uint16_t addr, uint8_t val, void *priv)
                     svga->writemask = val & 0xf;
                     break;
                 case 3:
+                    svga->render_gen++;
                     svga->charsetb = (((val >> 2) & 3) * 0x10000) + 2;
                     svga->charseta = ((val & 3) * 0x10000) + 2;
                     if (val & 0x10)
@@ -338,6 +347,8 @@ svga_out(uint16_t addr, uint8_t val, void *priv)
             }
             break;
         case 0x3c6:
+            if (svga->dac_mask != val)
+                svga->render_gen++;
             svga->dac_mask = val;
             break;
         case 0x3c7:
@@ -365,6 +376,7 @@ svga_out(uint16_t addr, uint8_t val, void *priv)
                     svga->vgapal[index].r = svga->dac_r;
                     svga->vgapal[index].g = svga->dac_g;
                     svga->vgapal[index].b = svga->dac_b;
+                    svga->render_gen++;
                     if (svga->ramdac_type == RAMDAC_8BIT)
                         svga->pallook[index] = makecol32(svga->vgapal[index].r, svga->vgapal[index].g, svga->vgapal[index].b);
                     else
@@ -716,6 +728,8 @@ svga_recalctimings(svga_t *svga)
 #endif
     }
 
+    svga->render_gen++;
+
     svga->vtotal      = svga->crtc[6];
     svga->dispend     = svga->crtc[0x12];
     svga->vsyncstart  = svga->crtc[0x10];
@@ -1281,13 +1295,14 @@ svga_recalctimings(svga_t *svga)
     }
 }
 
-static void
-svga_do_render(svga_t *svga)
+/* The line itself, returns 0 if nothing else is to be drawn on it. */
+static int
+svga_do_render_line(svga_t *svga)
 {
     /* Always render a blank screen and nothing else while in DPMS mode. */
     if (svga->dpms) {
         svga_render_blank(svga);
-        return;
+        return 0;
     }
 
     if (!svga->override) {
@@ -1295,6 +1310,24 @@ svga_do_render(svga_t *svga)
         svga->render(svga);
     }
 
+    return 1;
+}
+
+static void
+svga_do_render_overscan(svga_t *svga)
+{
+    if (!svga->override) {
+        svga->x_add = svga->left_overscan;
+        svga_render_overscan_left(svga);
+        svga_render_overscan_right(svga);
+        svga->x_add = svga->left_overscan - svga->scrollcache;
+    }
+}
+
+/* The overlay and hardware cursors on top of the line, then the overscan. */
+static void
+svga_do_render_extra(svga_t *svga)
+{
     if (svga->overlay_on) {
         if (!svga->override && svga->overlay_draw)
             svga->overlay_draw(svga, svga->displine + svga->y_add);
@@ -1320,12 +1353,332 @@ svga_do_render(svga_t *svga)
             svga->hwcursor_on--;
     }
 
-    if (!svga->override) {
-        svga->x_add = svga->left_overscan;
-        svga_render_overscan_left(svga);
-        svga_render_overscan_right(svga);
+    svga_do_render_overscan(svga);
+}
+
+static void
+svga_do_render(svga_t *svga)
+{
+    if (svga_do_render_line(svga))
+        svga_do_render_extra(svga);
+}
+
+/*
+ * Render worker.
+ *
+ * With vid_render_thread set, svga_poll() only records the per-line state the
+ * renderers need and queues it, the lines are rendered by a worker thread on
+ * its own copy of the svga_t. The copy is refreshed from a snapshot whenever
+ * render_gen has moved, and at the start of every frame, so that palette and
+ * mode changes done without going through svga_out() are picked up at least
+ * once per frame.
+ *
+ * The overlay and hardware cursor callbacks are never run by the worker, as
+ * they update card state (the latch addresses, overlay scaler accumulators
+ * and so on) and read registers of the card that are not part of the copy.
+ * A line that needs one of them is handed to the worker without the
+ * overscan, the emulation thread then waits for it and finishes the line on
+ * the live svga_t with svga_do_render_extra(), exactly as without the worker.
+ *
+ * VRAM is not copied, the worker reads it as it is when the line is rendered.
+ * The emulation thread waits for the worker to catch up at the end of the
+ * active display, before changedvram is aged and the frame is blitted, so all
+ * of the raster timing (cgastat, vsync, line compare) stays where it was.
+ */
+#define SVGA_RT_LINES     256
+#define SVGA_RT_LINE_MASK (SVGA_RT_LINES - 1)
+#define SVGA_RT_SNAPS     4
+#define SVGA_RT_SNAP_MASK (SVGA_RT_SNAPS - 1)
+/* Queued lines after which the worker is woken up. */
+#define SVGA_RT_BATCH     32
+
+typedef struct svga_rt_line_t {
+    uint8_t  snap;      /* load the next snapshot before this line */
+    uint8_t  new_frame; /* reset the drawn line range before this line */
+    uint8_t  extra;     /* the emulation thread finishes this line */
+
+    int      displine;
+    int      y_add;
+    int      x_add;
+    int      scrollcache;
+    int      half_pixel;
+    int      scanline;
+    int      cursorvisible;
+    int      cursoron;
+    int      blink;
+    int      fullchange;
+    int      oddeven;
+    int      start_retrace_latch;
+    uint32_t memaddr;
+} svga_rt_line_t;
+
+typedef struct svga_rt_t {
+    svga_t        *svga;
+    svga_t         rsvga;
+    svga_t         snaps[SVGA_RT_SNAPS];
+    svga_rt_line_t lines[SVGA_RT_LINES];
+
+    atomic_int     line_write_idx;
+    atomic_int     line_read_idx;
+    atomic_int     snap_write_idx;
+    atomic_int     snap_read_idx;
+
+    uint32_t       snap_gen;
+    int            snap_valid;
+    int            new_frame;
+
+    atomic_int     running;
+    thread_t      *thread;
+    event_t       *wake_event;
+    event_t       *done_event;
+} svga_rt_t;
+
+#define SVGA_RT_LINES_FULL  ((rt->line_write_idx - rt->line_read_idx) >= SVGA_RT_LINES)
+#define SVGA_RT_LINES_EMPTY (rt->line_read_idx == rt->line_write_idx)
+#define SVGA_RT_SNAPS_FULL  ((rt->snap_write_idx - rt->snap_read_idx) >= SVGA_RT_SNAPS)
+
+/* The part of svga_do_render() the CRTC emulation depends on. */
+static void
+svga_render_advance(svga_t *svga)
+{
+    if (svga->dpms)
+        return;
+
+    if (svga->overlay_on) {
+        svga->overlay_on--;
+        if (svga->overlay_on && svga->interlace)
+            svga->overlay_on--;
+    }
+
+    if (svga->dac_hwcursor_on) {
+        svga->dac_hwcursor_on--;
+        if (svga->dac_hwcursor_on && svga->interlace)
+            svga->dac_hwcursor_on--;
+    }
+
+    if (svga->hwcursor_on) {
+        svga->hwcursor_on--;
+        if (svga->hwcursor_on && svga->interlace)
+            svga->hwcursor_on--;
+    }
+
+    if (!svga->override)
         svga->x_add = svga->left_overscan - svga->scrollcache;
+}
+
+static void
+svga_rt_load_snap(svga_rt_t *rt, const svga_t *snap)
+{
+    svga_t *rsvga          = &rt->rsvga;
+    int     firstline_draw = rsvga->firstline_draw;
+    int     lastline_draw  = rsvga->lastline_draw;
+
+    memcpy(rsvga, snap, sizeof(svga_t));
+
+    rsvga->firstline_draw = firstline_draw;
+    rsvga->lastline_draw  = lastline_draw;
+
+    if (snap->map8 == rt->svga->pallook)
+        rsvga->map8 = rsvga->pallook;
+}
+
+static void
+svga_rt_render_line(svga_rt_t *rt, const svga_rt_line_t *line)
+{
+    svga_t *rsvga = &rt->rsvga;
+
+    if (line->snap) {
+        svga_rt_load_snap(rt, &rt->snaps[rt->snap_read_idx & SVGA_RT_SNAP_MASK]);
+        rt->snap_read_idx++;
     }
+
+    if (line->new_frame) {
+        rsvga->firstline_draw = 2000;
+        rsvga->lastline_draw  = 0;
+    }
+
+    rsvga->displine            = line->displine;
+    rsvga->y_add               = line->y_add;
+    rsvga->x_add               = line->x_add;
+    rsvga->scrollcache         = line->scrollcache;
+    rsvga->half_pixel          = line->half_pixel;
+    rsvga->scanline            = line->scanline;
+    rsvga->cursorvisible       = line->cursorvisible;
+    rsvga->cursoron            = line->cursoron;
+    rsvga->blink               = line->blink;
+    rsvga->fullchange          = line->fullchange;
+    rsvga->oddeven             = line->oddeven;
+    rsvga->start_retrace_latch = line->start_retrace_latch;
+    rsvga->memaddr             = line->memaddr;
+
+    if (svga_do_render_line(rsvga) && !line->extra)
+        svga_do_render_overscan(rsvga);
+}
+
+static void
+svga_rt_thread(void *priv)
+{
+    svga_rt_t *rt = (svga_rt_t *) priv;
+
+    while (rt->running) {
+        thread_set_event(rt->done_event);
+        thread_wait_event(rt->wake_event, -1);
+        thread_reset_event(rt->wake_event);
+
+        while (!SVGA_RT_LINES_EMPTY) {
+            svga_rt_render_line(rt, &rt->lines[rt->line_read_idx & SVGA_RT_LINE_MASK]);
+            rt->line_read_idx++;
+
+            if (!(rt->line_read_idx & (SVGA_RT_BATCH - 1)))
+                thread_set_event(rt->done_event);
+        }
+    }
+}
+
+/* Wait until the worker has rendered every queued line. */
+static void
+svga_rt_flush(svga_t *svga)
+{
+    svga_rt_t *rt = (svga_rt_t *) svga->render_thread;
+
+    if (rt == NULL)
+        return;
+
+    while (!SVGA_RT_LINES_EMPTY) {
+        thread_reset_event(rt->done_event);
+        if (!SVGA_RT_LINES_EMPTY) {
+            thread_set_event(rt->wake_event);
+            thread_wait_event(rt->done_event, 1);
+        }
+    }
+}
+
+static void
+svga_rt_queue_line(svga_t *svga)
+{
+    svga_rt_t      *rt   = (svga_rt_t *) svga->render_thread;
+    svga_rt_line_t *line = &rt->lines[rt->line_write_idx & SVGA_RT_LINE_MASK];
+    int             extra;
+
+    while (SVGA_RT_LINES_FULL) {
+        thread_reset_event(rt->done_event);
+        if (SVGA_RT_LINES_FULL) {
+            thread_set_event(rt->wake_event);
+            thread_wait_event(rt->done_event, 1);
+        }
+    }
+
+    line->snap = 0;
+    if (rt->new_frame || !rt->snap_valid || (rt->snap_gen != svga->render_gen)) {
+        while (SVGA_RT_SNAPS_FULL) {
+            thread_reset_event(rt->done_event);
+            if (SVGA_RT_SNAPS_FULL) {
+                thread_set_event(rt->wake_event);
+                thread_wait_event(rt->done_event, 1);
+            }
+        }
+
+        memcpy(&rt->snaps[rt->snap_write_idx & SVGA_RT_SNAP_MASK], svga, sizeof(svga_t));
+        rt->snap_write_idx++;
+        rt->snap_gen   = svga->render_gen;
+        rt->snap_valid = 1;
+        line->snap     = 1;
+    }
+
+    line->new_frame = rt->new_frame;
+    rt->new_frame   = 0;
+
+    /* The override and DPMS state of the copy can lag behind, so this is
+       decided on the live state; the worker always skips the callbacks. */
+    extra = !svga->dpms && !svga->override &&
+            ((svga->overlay_on && svga->overlay_draw) || (svga->dac_hwcursor_on && svga->dac_hwcursor_draw) ||
+             (svga->hwcursor_on && svga->hwcursor_draw));
+
+    line->extra               = extra;
+    line->displine            = svga->displine;
+    line->y_add               = svga->y_add;
+    line->x_add               = svga->x_add;
+    line->scrollcache         = svga->scrollcache;
+    line->half_pixel          = svga->half_pixel;
+    line->scanline            = svga->scanline;
+    line->cursorvisible       = svga->cursorvisible;
+    line->cursoron            = svga->cursoron;
+    line->blink               = svga->blink;
+    line->fullchange          = svga->fullchange;
+    line->oddeven             = svga->oddeven;
+    line->start_retrace_latch = svga->start_retrace_latch;
+    line->memaddr             = svga->memaddr;
+
+    rt->line_write_idx++;
+
+    if (extra) {
+        svga_rt_flush(svga);
+        svga_do_render_extra(svga);
+    } else {
+        if (!(rt->line_write_idx & (SVGA_RT_BATCH - 1)))
+            thread_set_event(rt->wake_event);
+
+        svga_render_advance(svga);
+    }
+}
+
+static void
+svga_rt_init(svga_t *svga)
+{
+    svga_rt_t *rt = (svga_rt_t *) calloc(1, sizeof(svga_rt_t));
+
+    rt->svga       = svga;
+    rt->running    = 1;
+    rt->new_frame  = 1;
+    rt->wake_event = thread_create_event();
+    rt->done_event = thread_create_event();
+    rt->thread     = thread_create(svga_rt_thread, rt);
+
+    svga->render_thread = rt;
+}
+
+static void
+svga_rt_close(svga_t *svga)
+{
+    svga_rt_t *rt = (svga_rt_t *) svga->render_thread;
+
+    if (rt == NULL)
+        return;
+
+    svga_rt_flush(svga);
+
+    rt->running = 0;
+    thread_set_event(rt->wake_event);
+    thread_wait(rt->thread);
+
+    thread_destroy_event(rt->wake_event);
+    thread_destroy_event(rt->done_event);
+
+    free(rt);
+    svga->render_thread = NULL;
+}
+
+/* Lines redrawn since the start of the frame, as tracked by the renderers. */
+static void
+svga_get_drawn_lines(svga_t *svga, int *first, int *last)
+{
+    const svga_t *src = svga->render_thread ? &((svga_rt_t *) svga->render_thread)->rsvga : svga;
+
+    *first = src->firstline_draw;
+    *last  = src->lastline_draw;
+}
+
+static void
+svga_render_line(svga_t *svga)
+{
+    int old_cat = prof_enter(PROF_RENDER);
+
+    if (svga->render_thread)
+        svga_rt_queue_line(svga);
+    else
+        svga_do_render(svga);
+
+    prof_leave(old_cat);
 }
 
 void
@@ -1338,6 +1691,8 @@ svga_poll(void *priv)
     int        wy;
     int        ret;
     int        old_ma;
+    int        first;
+    int        last;
 
     svga_log("SVGA Poll.\n");
     if (!svga->linepos) {
@@ -1382,6 +1737,8 @@ svga_poll(void *priv)
             if (svga->firstline == 2000) {
                 svga->firstline = svga->displine;
                 video_wait_for_buffer_monitor(svga->monitor_index);
+                if (svga->render_thread)
+                    ((svga_rt_t *) svga->render_thread)->new_frame = 1;
             }
 
             if (svga->hwcursor_on || svga->dac_hwcursor_on || svga->overlay_on)
@@ -1393,18 +1750,18 @@ svga_poll(void *priv)
                 svga->displine <<= 1;
                 svga->y_add <<= 1;
 
-                svga_do_render(svga);
+                svga_render_line(svga);
 
                 svga->displine++;
 
                 svga->memaddr = old_ma;
 
-                svga_do_render(svga);
+                svga_render_line(svga);
 
                 svga->y_add >>= 1;
                 svga->displine >>= 1;
             } else
-                svga_do_render(svga);
+                svga_render_line(svga);
 
             if (svga->lastline < svga->displine)
                 svga->lastline = svga->displine;
@@ -1523,6 +1880,8 @@ svga_poll(void *priv)
             }
         }
         if (svga->vc == svga->dispend) {
+            svga_rt_flush(svga);
+
             if (svga->vblank_start)
                 svga->vblank_start(svga);
 
@@ -1549,6 +1908,8 @@ svga_poll(void *priv)
                 svga->fullchange--;
         }
         if (svga->vc == svga->vsyncstart) {
+            svga_rt_flush(svga);
+
             svga->dispon = 0;
             svga->cgastat |= 8;
             x = svga->hdisp;
@@ -1561,14 +1922,16 @@ svga_poll(void *priv)
             wx = x;
 
             if (!svga->override) {
+                svga_get_drawn_lines(svga, &first, &last);
+
                 if (svga->vertical_linedbl) {
                     wy = (svga->lastline - svga->firstline) << 1;
                     svga->vdisp = wy + 1;
-                    svga_doblit(wx, wy, svga);
+                    svga_doblit_dirty(wx, wy, first, last, svga);
                 } else {
                     wy = svga->lastline - svga->firstline;
                     svga->vdisp = wy + 1;
-                    svga_doblit(wx, wy, svga);
+                    svga_doblit_dirty(wx, wy, first, last, svga);
                 }
             }
 
@@ -1678,6 +2041,8 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
     svga->monitor_index = monitor_index_global;
     svga->monitor       = &monitors[svga->monitor_index];
 
+    svga_render_check_sse2();
+
     for (int c = 0; c < 256; c++) {
         e = c;
         for (int d = 0; d < 8; d++) {
@@ -1772,12 +2137,17 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
 
     svga->map8            = svga->pallook;
 
+    if (vid_render_thread)
+        svga_rt_init(svga);
+
     return 0;
 }
 
 void
 svga_close(svga_t *svga)
 {
+    svga_rt_close(svga);
+
     free(svga->changedvram);
     free(svga->vram);
 
@@ -1787,6 +2157,67 @@ svga_close(svga_t *svga)
     svga_pri = NULL;
 }
 
+/* The generic VGA state, the card hook saves its own RAMDAC and extensions. */
+void
+svga_savestate(svga_t *svga, savestate_t *st)
+{
+    svga_rt_t *rt       = (svga_rt_t *) svga->render_thread;
+    uint32_t   vram_max = svga->vram_max;
+
+    if (st->saving && ((svga->dev8514 != NULL) || (svga->xga != NULL)))
+        savestate_refuse(st, "SVGA", "an 8514/A or XGA is attached");
+
+    savestate_var(st, vram_max);
+    if (!st->saving && !st->error && (vram_max != svga->vram_max)) {
+        pclog("SAVESTATE: State was saved with a different amount of video memory\n");
+        st->error = 1;
+    }
+
+    /* The worker must not render from the state while it is being replaced. */
+    svga_rt_flush(svga);
+
+    savestate_rw(st, &svga->fast, offsetof(svga_t, map8) - offsetof(svga_t, fast));
+    savestate_rw(st, svga->pallook, offsetof(svga_t, timer) - offsetof(svga_t, pallook));
+    savestate_timer(st, &svga->timer);
+    savestate_rw(st, &svga->hwcursor, offsetof(svga_t, render) - offsetof(svga_t, hwcursor));
+    savestate_var(st, svga->vga_enabled);
+    savestate_rw(st, svga->crtc, offsetof(svga_t, vram) - offsetof(svga_t, crtc));
+    savestate_rw(st, &svga->crtcreg, offsetof(svga_t, remap_required) - offsetof(svga_t, crtcreg));
+    savestate_rw(st, svga->vram, svga->vram_max);
+
+    if (st->saving || st->error)
+        return;
+
+    if (svga->priv_parent == NULL) {
+        io_removehandler(0x03a0, 0x0020, svga->video_in, NULL, NULL, svga->video_out, NULL, NULL, svga->priv);
+        if (!(svga->miscout & 1))
+            io_sethandler(0x03a0, 0x0020, svga->video_in, NULL, NULL, svga->video_out, NULL, NULL, svga->priv);
+    }
+
+    switch (svga->gdcreg[6] & 0x0c) {
+        case 0x0: /*128k at A0000*/
+            mem_mapping_set_addr(&svga->mapping, 0xa0000, 0x20000);
+            break;
+        case 0x4: /*64k at A0000*/
+            mem_mapping_set_addr(&svga->mapping, 0xa0000, 0x10000);
+            break;
+        case 0x8: /*32k at B0000*/
+            mem_mapping_set_addr(&svga->mapping, 0xb0000, 0x08000);
+            break;
+        default: /*32k at B8000*/
+            mem_mapping_set_addr(&svga->mapping, 0xb8000, 0x08000);
+            break;
+    }
+
+    svga_recalctimings(svga);
+    svga->fullchange = changeframecount;
+
+    if (rt != NULL) {
+        rt->snap_valid = 0;
+        rt->new_frame  = 1;
+    }
+}
+
 uint32_t
 svga_decode_addr(svga_t *svga, uint32_t addr, int write)
 {
@@ -2133,8 +2564,10 @@ svga_read_linear(uint32_t addr, void *priv)
     return svga_read_common(addr, 1, priv);
 }
 
-void
-svga_doblit(int wx, int wy, svga_t *svga)
+/* first and last are the displayed lines the renderers have redrawn since the
+   previous blit, first < 0 if that is not known. */
+static void
+svga_doblit_dirty(int wx, int wy, int first, int last, svga_t *svga)
 {
     int       y_add;
     int       x_add;
@@ -2146,6 +2579,9 @@ svga_doblit(int wx, int wy, svga_t *svga)
     int       j;
     int       xs_temp;
     int       ys_temp;
+    int       dirty_y;
+    int       dirty_h;
+    int       full = (first < 0) || enable_overscan;
 
     y_add   = enable_overscan ? svga->monitor->mon_overscan_y : 0;
     x_add   = enable_overscan ? svga->monitor->mon_overscan_x : 0;
@@ -2196,6 +2632,8 @@ svga_doblit(int wx, int wy, svga_t *svga)
 
         /* Block resolution changes while in DPMS mode to avoid getting a bogus
            screen width (320). We're already rendering a blank screen anyway. */
+        full = 1;
+
         if (!svga->dpms)
             set_screen_size_monitor(svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
 
@@ -2220,12 +2658,31 @@ svga_doblit(int wx, int wy, svga_t *svga)
         }
     }
 
-    video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    /* The overscan borders are not tracked, so they are always reported as dirty. */
+    if (full) {
+        dirty_y = 0;
+        dirty_h = svga->monitor->mon_ysize + y_add;
+    } else if (first > last) {
+        dirty_y = 0;
+        dirty_h = 0;
+    } else {
+        dirty_y = first + svga->y_add - y_start;
+        dirty_h = last - first + 1;
+    }
+
+    video_blit_memtoscreen_dirty_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add,
+                                         dirty_y, dirty_h, svga->monitor_index);
 
     if (svga->vertical_linedbl)
         svga->vertical_linedbl >>= 1;
 }
 
+void
+svga_doblit(int wx, int wy, svga_t *svga)
+{
+    svga_doblit_dirty(wx, wy, -1, -1, svga);
+}
+
 void
 svga_writeb_linear(uint32_t addr, uint8_t val, void *priv)
 {
@@ -27,6 +27,10 @@
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
 #include <86box/vid_svga_render_remap.h>
+#if defined __amd64__ || defined _M_X64 || defined __SSE2__
+#    define SVGA_RENDER_SSE2
+#    include <emmintrin.h>
+#endif
 
 uint32_t
 svga_lookup_lut_ram(svga_t* svga, uint32_t val)
@@ -42,6 +46,201 @@ svga_lookup_lut_ram(svga_t* svga, uint32_t val)
 
 #define lookup_lut(val) svga_lookup_lut_ram(svga, val)
 
+/*
+ * Whole-line kernels for the common direct colour formats. They are only
+ * used when the line is not remapped and does not wrap around the end of
+ * the displayed VRAM, so it can be read as one contiguous run. Each one
+ * converts the number of pixels the per-pixel loop would have produced,
+ * and returns 0 if it can not be used.
+ */
+
+/* Pixels produced by a loop running x from 0 to limit inclusive in steps of step. */
+static __inline int
+svga_span_count(int limit, int step)
+{
+    return (limit < 0) ? 0 : (((limit / step) + 1) * step);
+}
+
+static __inline int
+svga_span_contiguous(const svga_t *svga, int bytes)
+{
+    return ((uint64_t) svga->memaddr <= (uint64_t) svga->vram_display_mask) &&
+           ((uint64_t) svga->memaddr + bytes <= (uint64_t) svga->vram_display_mask + 1);
+}
+
+#ifdef SVGA_RENDER_SSE2
+/* Cleared by svga_render_check_sse2() if the SSE2 kernels are not exact. */
+static int svga_render_sse2 = 1;
+
+/*
+ * Eight 15/16bpp pixels to 32bpp, bit-exact with video_15to32[] and
+ * video_16to32[]. The tables scale each component as c * 255 / max,
+ * rounded down, which for these ranges equals (c * 1053) >> 7 for five
+ * bit and (c * 4145) >> 10 for six bit components; the components are
+ * moved to a position where a high multiply does that shift.
+ */
+static __inline void
+svga_conv8_16to32_sse2(uint32_t *p, const uint8_t *src, int bpp)
+{
+    const __m128i mask5  = _mm_set1_epi16(0x3e00);
+    const __m128i mask6  = _mm_set1_epi16(0x0fc0);
+    const __m128i mul5   = _mm_set1_epi16(1053);
+    const __m128i mul6   = _mm_set1_epi16(4145);
+    const __m128i alpha  = _mm_set1_epi16((short) 0xff00);
+    __m128i       pix    = _mm_loadu_si128((const __m128i *) src);
+    __m128i       b;
+    __m128i       g;
+    __m128i       r;
+    __m128i       bg;
+    __m128i       ra;
+
+    b = _mm_mulhi_epu16(_mm_and_si128(_mm_slli_epi16(pix, 9), mask5), mul5);
+    if (bpp == 15) {
+        g = _mm_mulhi_epu16(_mm_and_si128(_mm_slli_epi16(pix, 4), mask5), mul5);
+        r = _mm_mulhi_epu16(_mm_and_si128(_mm_srli_epi16(pix, 1), mask5), mul5);
+    } else {
+        g = _mm_mulhi_epu16(_mm_and_si128(_mm_slli_epi16(pix, 1), mask6), mul6);
+        r = _mm_mulhi_epu16(_mm_and_si128(_mm_srli_epi16(pix, 2), mask5), mul5);
+    }
+
+    bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+    ra = _mm_or_si128(r, alpha);
+    _mm_storeu_si128((__m128i *) p, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i *) (p + 4), _mm_unpackhi_epi16(bg, ra));
+}
+
+/* 32bpp to 32bpp with the alpha byte cleared, returns the pixels done. */
+static __inline int
+svga_conv_32to32_sse2(uint32_t *p, const uint32_t *src, int count)
+{
+    const __m128i mask = _mm_set1_epi32(0x00ffffff);
+    int           x    = 0;
+
+    for (; (x + 4) <= count; x += 4)
+        _mm_storeu_si128((__m128i *) &p[x], _mm_and_si128(_mm_loadu_si128((const __m128i *) &src[x]), mask));
+
+    return x;
+}
+#endif
+
+/*
+ * Compare the SSE2 kernels against the scalar conversions once, using
+ * every 15/16bpp value and a 32bpp pattern, and fall back to the scalar
+ * loops for good if they ever disagree.
+ */
+void
+svga_render_check_sse2(void)
+{
+#ifdef SVGA_RENDER_SSE2
+    static int checked = 0;
+    uint16_t   in[8];
+    uint32_t   out[8];
+    uint32_t   src[64];
+    uint32_t   dst[64];
+    uint32_t   seed = 0x86b0c5e5;
+    int        x;
+
+    if (checked)
+        return;
+    checked = 1;
+
+    for (int bpp = 15; bpp <= 16; bpp++) {
+        const uint32_t *table = (bpp == 15) ? video_15to32 : video_16to32;
+
+        for (uint32_t c = 0; c < 65536; c += 8) {
+            for (int i = 0; i < 8; i++)
+                in[i] = c + i;
+            svga_conv8_16to32_sse2(out, (const uint8_t *) in, bpp);
+            for (int i = 0; i < 8; i++) {
+                if (out[i] != table[c + i]) {
+                    pclog("SVGA: SSE2 %ibpp kernel gives %08X for %04X instead of %08X, using the scalar renderers\n",
+                          bpp, out[i], c + i, table[c + i]);
+                    svga_render_sse2 = 0;
+                    return;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < 64; i++) {
+        seed   = (seed * 1103515245) + 12345;
+        src[i] = seed;
+    }
+    x = svga_conv_32to32_sse2(dst, src, 64);
+    for (int i = 0; i < x; i++) {
+        if (dst[i] != (src[i] & 0x00ffffff)) {
+            pclog("SVGA: SSE2 32bpp kernel gives %08X for %08X, using the scalar renderers\n", dst[i], src[i]);
+            svga_render_sse2 = 0;
+            return;
+        }
+    }
+#endif
+}
+
+/* 15/16bpp, only with the RAMDAC's default colour conversion. */
+static int
+svga_render_span_16to32(svga_t *svga, uint32_t *p, int limit, int bpp)
+{
+    const uint32_t *table = (bpp == 15) ? video_15to32 : video_16to32;
+    const uint16_t *src;
+    int             count = svga_span_count(limit, 8);
+    int             x     = 0;
+
+    if (!count || (svga->conv_16to32 != svga_conv_16to32) || !svga_span_contiguous(svga, count << 1))
+        return 0;
+
+    src = (const uint16_t *) &svga->vram[svga->memaddr];
+#ifdef SVGA_RENDER_SSE2
+    if (svga_render_sse2) {
+        for (; x < count; x += 8)
+            svga_conv8_16to32_sse2(&p[x], (const uint8_t *) &src[x], bpp);
+    }
+#endif
+    for (; x < count; x++)
+        p[x] = table[src[x]];
+
+    return count;
+}
+
+/* 24bpp, only without a RAMDAC LUT. */
+static int
+svga_render_span_24to32(svga_t *svga, uint32_t *p, int limit)
+{
+    const uint8_t *src;
+    int            count = svga_span_count(limit, 4);
+
+    if (!count || svga->lut_map || !svga_span_contiguous(svga, count * 3))
+        return 0;
+
+    src = &svga->vram[svga->memaddr];
+    for (int x = 0; x < count; x++, src += 3)
+        p[x] = src[0] | (src[1] << 8) | (src[2] << 16);
+
+    return count;
+}
+
+/* 32bpp, only without a RAMDAC LUT. */
+static int
+svga_render_span_32to32(svga_t *svga, uint32_t *p, int limit)
+{
+    const uint32_t *src;
+    int             count = svga_span_count(limit, 1);
+    int             x     = 0;
+
+    if (!count || svga->lut_map || !svga_span_contiguous(svga, count << 2))
+        return 0;
+
+    src = (const uint32_t *) &svga->vram[svga->memaddr];
+#ifdef SVGA_RENDER_SSE2
+    if (svga_render_sse2)
+        x = svga_conv_32to32_sse2(p, src, count);
+#endif
+    for (; x < count; x++)
+        p[x] = src[x] & 0x00ffffff;
+
+    return count;
+}
+
 void
 svga_render_null(svga_t *svga)
 {
@@ -1611,22 +1810,25 @@ svga_render_15bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                x = svga_render_span_16to32(svga, p, svga->hdisp + svga->scrollcache, 15);
+                if (!x) {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                    }
                 }
                 svga->memaddr += x << 1;
             } else {
@@ -1843,22 +2045,25 @@ svga_render_16bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                x = svga_render_span_16to32(svga, p, svga->hdisp + svga->scrollcache, 16);
+                if (!x) {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 4) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 8) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1) + 12) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                    }
                 }
                 svga->memaddr += x << 1;
             } else {
@@ -2004,17 +2209,22 @@ svga_render_24bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
-                    dat0 = *(uint32_t *) (&svga->vram[svga->memaddr & svga->vram_display_mask]);
-                    dat1 = *(uint32_t *) (&svga->vram[(svga->memaddr + 4) & svga->vram_display_mask]);
-                    dat2 = *(uint32_t *) (&svga->vram[(svga->memaddr + 8) & svga->vram_display_mask]);
-
-                    *p++ = lookup_lut(dat0 & 0xffffff);
-                    *p++ = lookup_lut((dat0 >> 24) | ((dat1 & 0xffff) << 8));
-                    *p++ = lookup_lut((dat1 >> 16) | ((dat2 & 0xff) << 16));
-                    *p++ = lookup_lut(dat2 >> 8);
-
-                    svga->memaddr += 12;
+                x = svga_render_span_24to32(svga, p, svga->hdisp + svga->scrollcache);
+                if (x)
+                    svga->memaddr += x * 3;
+                else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
+                        dat0 = *(uint32_t *) (&svga->vram[svga->memaddr & svga->vram_display_mask]);
+                        dat1 = *(uint32_t *) (&svga->vram[(svga->memaddr + 4) & svga->vram_display_mask]);
+                        dat2 = *(uint32_t *) (&svga->vram[(svga->memaddr + 8) & svga->vram_display_mask]);
+
+                        *p++ = lookup_lut(dat0 & 0xffffff);
+                        *p++ = lookup_lut((dat0 >> 24) | ((dat1 & 0xffff) << 8));
+                        *p++ = lookup_lut((dat1 >> 16) | ((dat2 & 0xff) << 16));
+                        *p++ = lookup_lut(dat2 >> 8);
+
+                        svga->memaddr += 12;
+                    }
                 }
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
@@ -2132,9 +2342,12 @@ svga_render_32bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 2)) & svga->vram_display_mask]);
-                    *p++ = lookup_lut(dat & 0xffffff);
+                x = svga_render_span_32to32(svga, p, svga->hdisp + svga->scrollcache);
+                if (!x) {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 2)) & svga->vram_display_mask]);
+                        *p++ = lookup_lut(dat & 0xffffff);
+                    }
                 }
                 svga->memaddr += (x * 4);
             } else {
@@ -25,6 +25,7 @@
 #include <86box/rom.h>
 #include <86box/device.h>
 #include <86box/timer.h>
+#include <86box/savestate.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_vga.h>
@@ -215,6 +216,14 @@ vga_force_redraw(void *priv)
     vga->svga.fullchange = changeframecount;
 }
 
+static void
+vga_savestate(void *priv, savestate_t *st)
+{
+    vga_t *vga = (vga_t *) priv;
+
+    svga_savestate(&vga->svga, st);
+}
+
 const device_t vga_device = {
     .name          = "IBM VGA",
     .internal_name = "vga",
@@ -226,7 +235,8 @@ const device_t vga_device = {
     .available     = vga_available,
     .speed_changed = vga_speed_changed,
     .force_redraw  = vga_force_redraw,
-    .config        = NULL
+    .config        = NULL,
+    .savestate     = vga_savestate
 };
 
 const device_t ps1vga_device = {
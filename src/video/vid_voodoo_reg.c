@@ -102,6 +102,7 @@ voodoo_reg_writel(uint32_t addr, uint32_t val, void *priv)
 #endif
 
                 voodoo_wait_for_render_thread_idle(voodoo);
+                voodoo_render_rebalance(voodoo);
                 if (!(val & 1)) {
                     banshee_set_overlay_addr(voodoo->priv, voodoo->leftOverlayBuf);
                     thread_wait_mutex(voodoo->swap_mutex);
@@ -143,6 +144,7 @@ voodoo_reg_writel(uint32_t addr, uint32_t val, void *priv)
             voodoo->front_offset = params->front_offset;
 #endif
             voodoo_wait_for_render_thread_idle(voodoo);
+            voodoo_render_rebalance(voodoo);
             if (!(val & 1)) {
                 memset(voodoo->dirty_line, 1, sizeof(voodoo->dirty_line));
                 voodoo->front_offset = voodoo->params.front_offset;
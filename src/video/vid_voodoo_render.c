@@ -797,6 +797,7 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
         int       real_y = (state->y << 4) + 8;
         int       start_x;
         int       dx;
+        int       line;
         uint16_t *fb_mem;
         uint16_t *aux_mem;
 
@@ -825,13 +826,9 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
         else
             real_y >>= 4;
 
-        if (SLI_ENABLED) {
-            if (((real_y >> 1) & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        } else {
-            if ((real_y & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        }
+        line = (SLI_ENABLED ? (real_y >> 1) : real_y) & VOODOO_RENDER_LINE_MASK;
+        if (voodoo->render_line_thread[line] != odd_even)
+            goto next_line;
 
         start_x = x;
 
@@ -843,6 +840,8 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
         x  = (x + 0x7000) >> 16;
         x2 = (x2 + 0x7000) >> 16;
 
+        voodoo->render_line_pixels[line] += ((x2 > x) ? (x2 - x) : (x - x2)) + 1;
+
         voodoo_render_log("%03i:%03i : Ax=%08x start_x=%08x  dSdX=%016llx dx=%08x  s=%08x -> ", x, state->y, state->vertexAx << 8, start_x, params->tmu[0].dTdX, dx, state->tmu0_t);
 
         state->ir += (params->dRdX * dx);
@@ -1545,9 +1544,11 @@ voodoo_render_log("voodoo_triangle %i %i %i : vA %f, %f  vB %f, %f  vC %f, %f f
 }
 
 static void
-render_thread(void *param, int odd_even)
+voodoo_render_thread(void *param)
 {
-    voodoo_t *voodoo = (voodoo_t *) param;
+    const voodoo_render_param_t *render_param = (voodoo_render_param_t *) param;
+    voodoo_t                    *voodoo       = render_param->voodoo;
+    int                          odd_even     = render_param->index;
 
     while (voodoo->render_thread_run[odd_even]) {
         thread_set_event(voodoo->render_not_full_event[odd_even]);
@@ -1575,25 +1576,73 @@ render_thread(void *param, int odd_even)
     }
 }
 
+/*Every render thread walks every triangle, but only draws the scanlines that
+  render_line_thread[] assigns to it. As each pixel is owned by exactly one
+  thread and every thread processes the triangles in order, the result does
+  not depend on the number of threads.*/
 void
-voodoo_render_thread_1(void *param)
-{
-    render_thread(param, 0);
-}
-void
-voodoo_render_thread_2(void *param)
+voodoo_render_start(voodoo_t *voodoo)
 {
-    render_thread(param, 1);
+    if (voodoo->render_threads < 1)
+        voodoo->render_threads = 1;
+    else if (voodoo->render_threads > VOODOO_MAX_RENDER_THREADS)
+        voodoo->render_threads = VOODOO_MAX_RENDER_THREADS;
+
+    for (int c = 0; c < VOODOO_RENDER_LINES; c++) {
+        voodoo->render_line_thread[c] = c % voodoo->render_threads;
+        voodoo->render_line_pixels[c] = 0;
+    }
+
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->wake_render_thread[c]    = thread_create_event();
+        voodoo->render_not_full_event[c] = thread_create_event();
+        voodoo->render_param[c].voodoo   = voodoo;
+        voodoo->render_param[c].index    = c;
+        voodoo->render_thread_run[c]     = 1;
+        voodoo->render_thread[c]         = thread_create(voodoo_render_thread, &voodoo->render_param[c]);
+    }
 }
+
 void
-voodoo_render_thread_3(void *param)
+voodoo_render_stop(voodoo_t *voodoo)
 {
-    render_thread(param, 2);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_run[c] = 0;
+        thread_set_event(voodoo->wake_render_thread[c]);
+        thread_wait(voodoo->render_thread[c]);
+    }
+
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        thread_destroy_event(voodoo->wake_render_thread[c]);
+        thread_destroy_event(voodoo->render_not_full_event[c]);
+    }
 }
+
+/*Hands the scanlines out again, going by the pixels drawn on each of them
+  since the last call. Lines are given in order to the thread with the least
+  work so far, which is plain interleaving when the load is even, and moves
+  lines away from threads that got the busy parts of the screen otherwise.
+  Must only be called with all render threads idle.*/
 void
-voodoo_render_thread_4(void *param)
+voodoo_render_rebalance(voodoo_t *voodoo)
 {
-    render_thread(param, 3);
+    uint64_t load[VOODOO_MAX_RENDER_THREADS] = { 0 };
+    int      best;
+
+    if (voodoo->render_threads == 1)
+        return;
+
+    for (int c = 0; c < VOODOO_RENDER_LINES; c++) {
+        best = 0;
+        for (int t = 1; t < voodoo->render_threads; t++) {
+            if (load[t] < load[best])
+                best = t;
+        }
+
+        voodoo->render_line_thread[c] = best;
+        load[best] += voodoo->render_line_pixels[c] + 1;
+        voodoo->render_line_pixels[c] = 0;
+    }
 }
 
 void
@@ -1601,22 +1650,12 @@ voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 {
     voodoo_params_t *params_new = &voodoo->params_buffer[voodoo->params_write_idx & PARAM_MASK];
 
-    while (PARAM_FULL(0) || (voodoo->render_threads >= 2 && PARAM_FULL(1)) || (voodoo->render_threads == 4 && (PARAM_FULL(2) || PARAM_FULL(3)))) {
-        thread_reset_event(voodoo->render_not_full_event[0]);
-        if (voodoo->render_threads >= 2)
-            thread_reset_event(voodoo->render_not_full_event[1]);
-        if (voodoo->render_threads == 4) {
-            thread_reset_event(voodoo->render_not_full_event[2]);
-            thread_reset_event(voodoo->render_not_full_event[3]);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        while (PARAM_FULL(c)) {
+            thread_reset_event(voodoo->render_not_full_event[c]);
+            if (PARAM_FULL(c))
+                thread_wait_event(voodoo->render_not_full_event[c], -1); /*Wait for room in ringbuffer*/
         }
-        if (PARAM_FULL(0))
-            thread_wait_event(voodoo->render_not_full_event[0], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads >= 2 && PARAM_FULL(1))
-            thread_wait_event(voodoo->render_not_full_event[1], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(2))
-            thread_wait_event(voodoo->render_not_full_event[2], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(3))
-            thread_wait_event(voodoo->render_not_full_event[3], -1); /*Wait for room in ringbuffer*/
     }
 
     voodoo_use_texture(voodoo, params, 0);
@@ -1627,6 +1666,10 @@ voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 
     voodoo->params_write_idx++;
 
-    if (PARAM_ENTRIES(0) < 4 || (voodoo->render_threads >= 2 && PARAM_ENTRIES(1) < 4) || (voodoo->render_threads == 4 && (PARAM_ENTRIES(2) < 4 || PARAM_ENTRIES(3) < 4)))
-        voodoo_wake_render_thread(voodoo);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (PARAM_ENTRIES(c) < 4) {
+            voodoo_wake_render_thread(voodoo);
+            break;
+        }
+    }
 }
@@ -12,6 +12,7 @@
  *
  *          Copyright 2008-2020 Sarah Walker.
  */
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -56,6 +57,161 @@ voodoo_texture_log(const char *fmt, ...)
 #    define voodoo_texture_log(fmt, ...)
 #endif
 
+/*Returns 1 while any render thread still has a queued triangle using the texture.*/
+static int
+voodoo_texture_in_use(voodoo_t *voodoo, texture_t *texture)
+{
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (texture->refcount != texture->refcount_r[c])
+            return 1;
+    }
+
+    return 0;
+}
+
+/*Waits for the render threads to drop their references, counting the stall.*/
+static void
+voodoo_texture_wait_idle(voodoo_t *voodoo)
+{
+    uint32_t start = plat_get_ticks();
+
+    voodoo_wait_for_render_thread_idle(voodoo);
+
+    voodoo->texture_stalls++;
+    voodoo->texture_stall_ms += plat_get_ticks() - start;
+}
+
+static uint32_t
+voodoo_texture_hash(voodoo_t *voodoo, uint32_t base, uint32_t tLOD, uint32_t palette_checksum)
+{
+    uint32_t hash = base ^ (tLOD * 0x9e3779b1) ^ (palette_checksum * 0x85ebca6b);
+
+    return (hash ^ (hash >> 15)) & voodoo->texture_hash_mask;
+}
+
+/*Adds the texture to, or removes it from, the reverse map of every 1 kB page
+  of texture memory it was converted from. texture_present[] is kept as a
+  quick check of whether any texture at all uses a page.*/
+static void
+voodoo_texture_map_pages(voodoo_t *voodoo, int tmu, int c, int add)
+{
+    const texture_t *texture   = &voodoo->texture_cache[tmu][c];
+    uint32_t         page_mask = voodoo->texture_mask >> TEX_DIRTY_SHIFT;
+    uint64_t         bit       = (uint64_t) 1 << (c & 63);
+
+    for (uint8_t d = 0; d < 4; d++) {
+        uint32_t first;
+        uint32_t count;
+
+        if (texture->addr_end[d] == 0)
+            continue;
+
+        first = texture->addr_start[d] >> TEX_DIRTY_SHIFT;
+        count = (texture->addr_end[d] >> TEX_DIRTY_SHIFT) - first + 1;
+        if (count > (page_mask + 1))
+            count = page_mask + 1;
+
+        for (uint32_t p = 0; p < count; p++) {
+            uint32_t  page  = (first + p) & page_mask;
+            uint64_t *words = &voodoo->texture_pages[tmu][page * voodoo->texture_page_words];
+
+            if (add) {
+                words[c >> 6] |= bit;
+                voodoo->texture_present[tmu][page] = 1;
+            } else if (words[c >> 6] & bit) {
+                int w;
+
+                words[c >> 6] &= ~bit;
+                for (w = 0; w < voodoo->texture_page_words; w++) {
+                    if (words[w])
+                        break;
+                }
+                if (w == voodoo->texture_page_words)
+                    voodoo->texture_present[tmu][page] = 0;
+            }
+        }
+    }
+}
+
+/*Unlinks the texture from its hash chain and the page reverse map.*/
+static void
+voodoo_texture_remove(voodoo_t *voodoo, int tmu, int c)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+    int       *prev;
+
+    if (texture->base == (uint32_t) -1)
+        return;
+
+    prev = &voodoo->texture_hash[tmu][voodoo_texture_hash(voodoo, texture->base, texture->tLOD, texture->palette_checksum)];
+    while (*prev != c)
+        prev = &voodoo->texture_cache[tmu][*prev].hash_next;
+    *prev = texture->hash_next;
+
+    voodoo_texture_map_pages(voodoo, tmu, c, 0);
+
+    texture->base      = -1; /*invalid*/
+    texture->hash_next = -1;
+}
+
+void
+voodoo_texture_cache_init(voodoo_t *voodoo, int size)
+{
+    if (size < TEX_CACHE_MIN)
+        size = TEX_CACHE_MIN;
+    else if (size > TEX_CACHE_MAX)
+        size = TEX_CACHE_MAX;
+    /*Round robin eviction below needs a power of two.*/
+    while (size & (size - 1))
+        size &= size - 1;
+
+    voodoo->texture_cache_size = size;
+    voodoo->texture_hash_mask  = (size * 2) - 1;
+    voodoo->texture_page_words = size >> 6;
+
+    /*The render threads look at both TMUs' entries even on single TMU
+      cards, so both tables always exist. Texture data is only allocated
+      once an entry is first used.*/
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        voodoo->texture_cache[tmu] = calloc(size, sizeof(texture_t));
+        voodoo->texture_hash[tmu]  = malloc(size * 2 * sizeof(int));
+        voodoo->texture_pages[tmu] = calloc(TEX_DIRTY_PAGES * voodoo->texture_page_words, sizeof(uint64_t));
+
+        for (int c = 0; c < size; c++) {
+            voodoo->texture_cache[tmu][c].base      = -1; /*invalid*/
+            voodoo->texture_cache[tmu][c].hash_next = -1;
+        }
+        for (int c = 0; c < (size * 2); c++)
+            voodoo->texture_hash[tmu][c] = -1;
+    }
+}
+
+void
+voodoo_texture_cache_close(voodoo_t *voodoo)
+{
+    uint64_t lookups = voodoo->texture_hits + voodoo->texture_misses;
+
+    if (lookups)
+        pclog("Voodoo: Texture cache %" PRIu64 " hits, %" PRIu64 " misses (%.1f%% hit rate), "
+              "%" PRIu64 " render thread stalls, %" PRIu64 " ms stalled\n",
+              voodoo->texture_hits, voodoo->texture_misses,
+              (100.0 * (double) voodoo->texture_hits) / (double) lookups,
+              voodoo->texture_stalls, voodoo->texture_stall_ms);
+
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        if (voodoo->texture_cache[tmu] != NULL) {
+            for (int c = 0; c < voodoo->texture_cache_size; c++)
+                free(voodoo->texture_cache[tmu][c].data);
+        }
+        free(voodoo->texture_cache[tmu]);
+        free(voodoo->texture_hash[tmu]);
+        free(voodoo->texture_pages[tmu]);
+        voodoo->texture_cache[tmu] = NULL;
+        voodoo->texture_hash[tmu]  = NULL;
+        voodoo->texture_pages[tmu] = NULL;
+    }
+}
+
 void
 voodoo_recalc_tex12(voodoo_t *voodoo, int tmu)
 {
@@ -244,8 +400,9 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     int      lod_min;
     int      lod_max;
     uint32_t addr = 0;
-    uint32_t addr_end;
     uint32_t palette_checksum;
+    uint32_t tLOD;
+    uint32_t hash;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
     lod_max = (params->tLOD[tmu] >> 8) & 15;
@@ -269,36 +426,40 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     else
         addr = params->texBaseAddr[tmu];
 
+    tLOD = params->tLOD[tmu] & 0xf00fff;
+    hash = voodoo_texture_hash(voodoo, addr, tLOD, palette_checksum);
+
     /*Try to find texture in cache*/
-    for (c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base == addr && voodoo->texture_cache[tmu][c].tLOD == (params->tLOD[tmu] & 0xf00fff) && voodoo->texture_cache[tmu][c].palette_checksum == palette_checksum) {
+    for (c = voodoo->texture_hash[tmu][hash]; c != -1; c = voodoo->texture_cache[tmu][c].hash_next) {
+        if (voodoo->texture_cache[tmu][c].base == addr && voodoo->texture_cache[tmu][c].tLOD == tLOD && voodoo->texture_cache[tmu][c].palette_checksum == palette_checksum) {
             params->tex_entry[tmu] = c;
             voodoo->texture_cache[tmu][c].refcount++;
+            voodoo->texture_hits++;
             return;
         }
     }
+    voodoo->texture_misses++;
 
     /*Texture not found, search for unused texture*/
     do {
-        for (c = 0; c < TEX_CACHE_MAX; c++) {
+        for (c = 0; c < voodoo->texture_cache_size; c++) {
             voodoo->texture_last_removed++;
-            voodoo->texture_last_removed &= (TEX_CACHE_MAX - 1);
-            if (voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[0] && (voodoo->render_threads == 1 || voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[1]))
+            voodoo->texture_last_removed &= (voodoo->texture_cache_size - 1);
+            if (!voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][voodoo->texture_last_removed]))
                 break;
         }
-        if (c == TEX_CACHE_MAX)
-            voodoo_wait_for_render_thread_idle(voodoo);
-    } while (c == TEX_CACHE_MAX);
-    if (c == TEX_CACHE_MAX)
-        fatal("Texture cache full!\n");
+        if (c == voodoo->texture_cache_size)
+            voodoo_texture_wait_idle(voodoo);
+    } while (c == voodoo->texture_cache_size);
 
     c = voodoo->texture_last_removed;
 
-    if ((voodoo->params.tLOD[tmu] & LOD_SPLIT) && (voodoo->params.tLOD[tmu] & LOD_ODD) && (voodoo->params.tLOD[tmu] & LOD_TMULTIBASEADDR))
-        voodoo->texture_cache[tmu][c].base = params->texBaseAddr1[tmu];
-    else
-        voodoo->texture_cache[tmu][c].base = params->texBaseAddr[tmu];
-    voodoo->texture_cache[tmu][c].tLOD = params->tLOD[tmu] & 0xf00fff;
+    voodoo_texture_remove(voodoo, tmu, c);
+    if (voodoo->texture_cache[tmu][c].data == NULL)
+        voodoo->texture_cache[tmu][c].data = malloc((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4);
+
+    voodoo->texture_cache[tmu][c].base = addr;
+    voodoo->texture_cache[tmu][c].tLOD = tLOD;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
     lod_max = (params->tLOD[tmu] >> 8) & 15;
@@ -534,60 +695,43 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     } else
         voodoo->texture_cache[tmu][c].addr_start[3] = voodoo->texture_cache[tmu][c].addr_end[3] = 0;
 
-    for (uint8_t d = 0; d < 4; d++) {
-        addr     = voodoo->texture_cache[tmu][c].addr_start[d];
-        addr_end = voodoo->texture_cache[tmu][c].addr_end[d];
-
-        if (addr_end != 0) {
-            for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
-                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-        }
-    }
+    voodoo->texture_cache[tmu][c].hash_next = voodoo->texture_hash[tmu][hash];
+    voodoo->texture_hash[tmu][hash]         = c;
+    voodoo_texture_map_pages(voodoo, tmu, c, 1);
 
     params->tex_entry[tmu] = c;
     voodoo->texture_cache[tmu][c].refcount++;
 }
 
+/*Evicts every texture converted from the 1 kB page holding dirty_addr.*/
 void
 flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
 {
-    int wait_for_idle = 0;
+    uint64_t *words         = &voodoo->texture_pages[tmu][(dirty_addr >> TEX_DIRTY_SHIFT) * voodoo->texture_page_words];
+    int       wait_for_idle = 0;
 
-    memset(voodoo->texture_present[tmu], 0, sizeof(voodoo->texture_present[0]));
 #if 0
-    voodoo_texture_log("Evict %08x %i\n", dirty_addr, sizeof(voodoo->texture_present));
+    voodoo_texture_log("Evict %08x\n", dirty_addr);
 #endif
-    for (uint8_t c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base != -1) {
-            for (uint8_t d = 0; d < 4; d++) {
-                int addr_start = voodoo->texture_cache[tmu][c].addr_start[d];
-                int addr_end   = voodoo->texture_cache[tmu][c].addr_end[d];
-
-                if (addr_end != 0) {
-                    int addr_start_masked = addr_start & voodoo->texture_mask & ~0x3ff;
-                    int addr_end_masked   = ((addr_end & voodoo->texture_mask) + 0x3ff) & ~0x3ff;
-
-                    if (addr_end_masked < addr_start_masked)
-                        addr_end_masked = voodoo->texture_mask + 1;
-                    if (dirty_addr >= addr_start_masked && dirty_addr < addr_end_masked) {
+    for (int w = 0; w < voodoo->texture_page_words; w++) {
+        uint64_t mask = words[w];
+
+        for (int b = 0; mask; b++, mask >>= 1) {
+            if (mask & 1) {
+                int c = (w << 6) + b;
+
 #if 0
-                        voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
+                voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
 #endif
+                if (voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][c]))
+                    wait_for_idle = 1;
 
-                        if (voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[0] || (voodoo->render_threads == 2 && voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[1]))
-                            wait_for_idle = 1;
-
-                        voodoo->texture_cache[tmu][c].base = -1;
-                    } else {
-                        for (; addr_start <= addr_end; addr_start += (1 << TEX_DIRTY_SHIFT))
-                            voodoo->texture_present[tmu][(addr_start & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-                    }
-                }
+                voodoo_texture_remove(voodoo, tmu, c);
             }
         }
     }
     if (wait_for_idle)
-        voodoo_wait_for_render_thread_idle(voodoo);
+        voodoo_texture_wait_idle(voodoo);
 }
 
 void
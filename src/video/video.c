@@ -234,6 +234,7 @@ const uint32_t shade[5][256] = {
 
 typedef struct blit_data_struct {
     int x, y, w, h;
+    int dirty_y, dirty_h;
     int busy;
     int buffer_in_use;
     int thread_run;
@@ -458,14 +459,25 @@ blit_thread(void *param)
     }
 }
 
+/* Rows dirty_y to dirty_y + dirty_h - 1 of the blitted area, counted from y,
+   are the only ones that may differ from the previous blit of the same area. */
 void
-video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, int dirty_y, int dirty_h, int monitor_index)
 {
     MTR_BEGIN("video", "video_blit_memtoscreen");
 
     if ((w <= 0) || (h <= 0))
         return;
 
+    if (dirty_y < 0) {
+        dirty_h += dirty_y;
+        dirty_y = 0;
+    }
+    if ((dirty_y + dirty_h) > h)
+        dirty_h = h - dirty_y;
+    if (dirty_h <= 0)
+        dirty_y = dirty_h = 0;
+
     video_wait_for_blit_monitor(monitor_index);
 
     monitors[monitor_index].mon_blit_data_ptr->busy          = 1;
@@ -474,12 +486,30 @@ video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
     monitors[monitor_index].mon_blit_data_ptr->y             = y;
     monitors[monitor_index].mon_blit_data_ptr->w             = w;
     monitors[monitor_index].mon_blit_data_ptr->h             = h;
+    monitors[monitor_index].mon_blit_data_ptr->dirty_y       = dirty_y;
+    monitors[monitor_index].mon_blit_data_ptr->dirty_h       = dirty_h;
     monitors[monitor_index].mon_renderedframes++;
 
     thread_set_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
     MTR_END("video", "video_blit_memtoscreen");
 }
 
+void
+video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+{
+    video_blit_memtoscreen_dirty_monitor(x, y, w, h, 0, h, monitor_index);
+}
+
+/* For blit backends: the dirty rows of the blit in progress. */
+void
+video_blit_get_dirty_monitor(int monitor_index, int *dirty_y, int *dirty_h)
+{
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    *dirty_y = blit_data_ptr->dirty_y;
+    *dirty_h = blit_data_ptr->dirty_h;
+}
+
 uint8_t
 pixels8(uint32_t *pixels)
 {
@@ -34,6 +34,9 @@
 #define VNC_MAX_X 2048
 #define VNC_MIN_Y 200
 #define VNC_MAX_Y 2048
+/* Granularity of the changed areas reported to the clients. */
+#define VNC_TILE_W 64
+#define VNC_TILE_H 16
 
 static rfbScreenInfoPtr rfb = NULL;
 static int              clients;
@@ -43,6 +46,12 @@ static int              allowedY;
 static int              ptr_x;
 static int              ptr_y;
 static int              ptr_but;
+/* Set when the frame buffer may be out of sync with the last blit. */
+static int              vnc_full = 1;
+static int              vnc_blit_x;
+static int              vnc_blit_y;
+static int              vnc_blit_w;
+static int              vnc_blit_h;
 
 #ifdef ENABLE_VNC_LOG
 int vnc_do_log = ENABLE_VNC_LOG;
@@ -171,24 +180,99 @@ vnc_display(rfbClientPtr cl)
     }
 }
 
+/* Copy the dirty rows of a blit, marking only the tiles that actually changed. */
+static void
+vnc_blit_tiles(int x, int y, int w, int dirty_y, int dirty_h)
+{
+    uint8_t   changed[VNC_MAX_X / VNC_TILE_W];
+    uint32_t *fb;
+    uint32_t *src;
+    int       ty;
+    int       row;
+    int       row_end;
+    int       tx;
+    int       cx;
+    int       cw;
+    int       run;
+
+    for (ty = dirty_y - (dirty_y % VNC_TILE_H); ty < (dirty_y + dirty_h); ty += VNC_TILE_H) {
+        memset(changed, 0x00, sizeof(changed));
+
+        row     = (ty < dirty_y) ? dirty_y : ty;
+        row_end = ((ty + VNC_TILE_H) > (dirty_y + dirty_h)) ? (dirty_y + dirty_h) : (ty + VNC_TILE_H);
+        for (; row < row_end; row++) {
+            fb  = &((uint32_t *) rfb->frameBuffer)[row * VNC_MAX_X];
+            src = &(buffer32->line[y + row][x]);
+
+            for (tx = 0; (tx * VNC_TILE_W) < w; tx++) {
+                cx = tx * VNC_TILE_W;
+                cw = ((cx + VNC_TILE_W) > w) ? (w - cx) : VNC_TILE_W;
+
+                if (memcmp(&fb[cx], &src[cx], cw * sizeof(uint32_t))) {
+                    memcpy(&fb[cx], &src[cx], cw * sizeof(uint32_t));
+                    changed[tx] = 1;
+                }
+            }
+        }
+
+        /* Report runs of changed tiles as one rectangle each. */
+        for (tx = 0; (tx * VNC_TILE_W) < w; tx++) {
+            if (!changed[tx])
+                continue;
+
+            for (run = tx; ((run + 1) * VNC_TILE_W < w) && changed[run + 1]; run++)
+                ;
+
+            if (((tx * VNC_TILE_W) < allowedX) && (ty < allowedY))
+                rfbMarkRectAsModified(rfb, tx * VNC_TILE_W, ty,
+                                      ((run + 1) * VNC_TILE_W > allowedX) ? allowedX : ((run + 1) * VNC_TILE_W),
+                                      ((ty + VNC_TILE_H) > allowedY) ? allowedY : (ty + VNC_TILE_H));
+            tx = run;
+        }
+    }
+}
+
 static void
 vnc_blit(int x, int y, int w, int h, int monitor_index)
 {
+    int dirty_y;
+    int dirty_h;
+
     if (monitor_index || (x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (buffer32 == NULL)) {
+        vnc_full = 1;
+        video_blit_complete_monitor(monitor_index);
+        return;
+    }
+
+    if (vnc_full || updatingSize || (x != vnc_blit_x) || (y != vnc_blit_y) || (w != vnc_blit_w) || (h != vnc_blit_h)) {
+        for (int row = 0; row < h; ++row)
+            video_copy(&(((uint8_t *) rfb->frameBuffer)[row * VNC_MAX_X * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+
+        vnc_blit_x = x;
+        vnc_blit_y = y;
+        vnc_blit_w = w;
+        vnc_blit_h = h;
+
+        if (screenshots)
+            video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
+
         video_blit_complete_monitor(monitor_index);
+
+        /* Clients are only told about it once the resize is through. */
+        vnc_full = updatingSize;
+        if (!updatingSize)
+            rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
         return;
     }
 
-    for (int row = 0; row < h; ++row)
-        video_copy(&(((uint8_t *) rfb->frameBuffer)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    video_blit_get_dirty_monitor(monitor_index, &dirty_y, &dirty_h);
+    if (dirty_h > 0)
+        vnc_blit_tiles(x, y, w, dirty_y, dirty_h);
 
     if (screenshots)
         video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
 
     video_blit_complete_monitor(monitor_index);
-
-    if (!updatingSize)
-        rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
 }
 
 /* Initialize VNC for operation. */
@@ -217,6 +301,7 @@ vnc_init(UNUSED(void *arg))
         updatingSize = 0;
         allowedX     = scrnsz_x;
         allowedY     = scrnsz_y;
+        vnc_full     = 1;
 
         rfb              = rfbGetScreen(0, NULL, VNC_MAX_X, VNC_MAX_Y, 8, 3, 4);
         rfb->desktopName = title;
@@ -285,6 +370,7 @@ vnc_resize(int x, int y)
 
         rfb->width  = x;
         rfb->height = y;
+        vnc_full    = 1;
 
         iterator = rfbGetClientIterator(rfb);
         while ((cl = rfbClientIteratorNext(iterator)) != NULL) {